@@ -69,7 +69,9 @@ namespace ifap
         {
             const ImageFileIndexer& indexer = m_texture_cache;
             size_t count = indexer.size();
-            if (!count)
+
+            // Navigation starts once the opened file has its place in the index.
+            if (!count || m_current_index == TextureCache::unresolved_index)
             {
                 return;
             }
@@ -440,14 +442,15 @@ namespace ifap
         // onSwapchainResize, which is driven from beginDraw(), not Window::onResize).
     }
 
-    void AppView::renderFrame()
+    void AppView::renderFrame(const ImageDrawRequest& request)
     {
         const bool blend = !m_window.isKeyPressed(KEYCODE_B);
         const bool frame_active = m_renderer.beginFrame(0.06f, 0.06f, 0.06f, 1.0f, blend);
 
         if (frame_active && m_current_task && m_current_task->texture)
         {
-            m_renderer.drawImage(makeDrawRequest());
+            m_renderer.drawImage(request);
+            m_texture_cache.drawTiles(m_current_task, request);
         }
 
         m_renderer.endFrame();
@@ -470,15 +473,33 @@ namespace ifap
             return;
         }
 
+        // A cached index that turned out to be stale was replaced by the indexer; keep
+        // showing the same file at its new position.
+        if (m_texture_cache.syncIndexer(m_current_index))
+        {
+            // No task yet when the view was parked on an unopened container.
+            if (!m_current_task || m_current_task->index != m_current_index)
+            {
+                m_current_task = m_texture_cache.getTexture(m_current_index, true);
+                m_awaiting_display = true;
+            }
+        }
+
         const ImageFileIndexer& indexer = m_texture_cache;
 
         if (indexer.size() > 0 && m_current_index < indexer.size())
         {
-            std::string filename = indexer[m_current_index];
-            std::string title = fmt::format("[{} / {}] {}",
-                m_current_index + 1, indexer.size(), filename);
+            // Lock-free lookup; the name is formatted straight from the index storage.
+            const FilenameTable::View filename = indexer[m_current_index];
+            std::string title = fmt::format("[{} / {}] {}{}",
+                m_current_index + 1, indexer.size(), filename.folder, filename.name);
             m_window.setTitle(title);
         }
+        else if (m_current_task)
+        {
+            // Opened ahead of the index walk.
+            m_window.setTitle(fmt::format("[? / {}] {}", indexer.size(), m_current_task->name));
+        }
         else
         {
             m_window.setTitle("iFap Image Viewer");
@@ -506,9 +527,18 @@ namespace ifap
 
         // Input and texture work before swapchain acquire so event handling stays
         // responsive even when the GPU is busy decoding/uploading.
-        const bool texture_progress = m_texture_cache.update(m_current_index, m_current_task);
+        bool texture_progress = m_texture_cache.update(m_current_index, m_current_task);
+
+        // Full-detail tiles under the current pan / zoom (oversize images only); the
+        // tiles are picked for the same request the frame draws.
+        const ImageDrawRequest request = makeDrawRequest();
+
+        if (m_texture_cache.updateTiles(m_current_task, request, m_window.getWindowSize()))
+        {
+            texture_progress = true;
+        }
 
-        renderFrame();
+        renderFrame(request);
 
         if (m_current_task && m_current_task->present_settle_frames > 0)
         {
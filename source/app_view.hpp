@@ -89,7 +89,7 @@ namespace ifap
 
         ImageDrawRequest makeDrawRequest() const;
 
-        void renderFrame();
+        void renderFrame(const ImageDrawRequest& request);
         void requestRedraw();
         void scheduleNextFrame();
         bool needsContinuousUpdate() const;
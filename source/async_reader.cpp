@@ -0,0 +1,542 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "async_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fstream>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ifap
+{
+    using namespace mango;
+
+#if defined(__linux__)
+
+    namespace
+    {
+
+        u32 loadAcquire(u32* value)
+        {
+            return std::atomic_ref<u32>(*value).load(std::memory_order_acquire);
+        }
+
+        void storeRelease(u32* value, u32 x)
+        {
+            std::atomic_ref<u32>(*value).store(x, std::memory_order_release);
+        }
+
+    } // namespace
+
+    AsyncFileReader::AsyncFileReader(u32 depth, size_t request_size)
+        : m_depth(std::max(1u, depth))
+        , m_request_size(request_size)
+        , m_requests(m_depth)
+    {
+        // Room for a cancel per read plus the short-read resubmissions queued alongside.
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        m_ring = int(::syscall(__NR_io_uring_setup, m_depth * 2, &params));
+        if (m_ring < 0)
+        {
+            return;
+        }
+
+        m_sq_memory_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        m_cq_memory_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+        {
+            m_sq_memory_size = m_cq_memory_size = std::max(m_sq_memory_size, m_cq_memory_size);
+        }
+
+        auto map = [this] (size_t size, off_t offset) -> void*
+        {
+            void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, offset);
+            return address == MAP_FAILED ? nullptr : address;
+        };
+
+        m_sq_memory = map(m_sq_memory_size, IORING_OFF_SQ_RING);
+        m_cq_memory = single ? m_sq_memory : map(m_cq_memory_size, IORING_OFF_CQ_RING);
+
+        m_sqe_memory_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqe_memory = map(m_sqe_memory_size, IORING_OFF_SQES);
+
+        if (!m_sq_memory || !m_cq_memory || !m_sqe_memory)
+        {
+            destroy();
+            return;
+        }
+
+        u8* sq = reinterpret_cast<u8*>(m_sq_memory);
+        u8* cq = reinterpret_cast<u8*>(m_cq_memory);
+
+        m_sq_head = reinterpret_cast<u32*>(sq + params.sq_off.head);
+        m_sq_tail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+        m_sq_mask = reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<u32*>(sq + params.sq_off.array);
+        m_cq_head = reinterpret_cast<u32*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+        m_cq_mask = reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+        m_sqes = m_sqe_memory;
+        m_cqes = cq + params.cq_off.cqes;
+    }
+
+    AsyncFileReader::~AsyncFileReader()
+    {
+        close();
+        destroy();
+    }
+
+    void AsyncFileReader::destroy()
+    {
+        if (m_sqe_memory)
+        {
+            ::munmap(m_sqe_memory, m_sqe_memory_size);
+        }
+
+        if (m_cq_memory && m_cq_memory != m_sq_memory)
+        {
+            ::munmap(m_cq_memory, m_cq_memory_size);
+        }
+
+        if (m_sq_memory)
+        {
+            ::munmap(m_sq_memory, m_sq_memory_size);
+        }
+
+        if (m_ring >= 0)
+        {
+            ::close(m_ring);
+        }
+
+        m_sqe_memory = nullptr;
+        m_cq_memory = nullptr;
+        m_sq_memory = nullptr;
+        m_ring = -1;
+    }
+
+    bool AsyncFileReader::open(const std::string& pathname, u64& size)
+    {
+        close();
+
+        if (m_ring < 0)
+        {
+            return false;
+        }
+
+        const int fd = ::open(pathname.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        m_file = fd;
+        size = u64(info.st_size);
+        return true;
+    }
+
+    void AsyncFileReader::close()
+    {
+        if (m_file >= 0)
+        {
+            ::close(m_file);
+            m_file = -1;
+        }
+    }
+
+    u64 AsyncFileReader::tag(size_t slot) const
+    {
+        // 0 is reserved for cancel completions.
+        return (m_generation << 16) | u64(slot + 1);
+    }
+
+    void AsyncFileReader::submitRead(size_t slot, u8* base)
+    {
+        const Request& request = m_requests[slot];
+
+        const u32 tail = *m_sq_tail;
+        const u32 index = tail & *m_sq_mask;
+
+        io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(m_sqes) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = m_file;
+        sqe->addr = u64(reinterpret_cast<uintptr_t>(base + request.offset));
+        sqe->len = request.length;
+        sqe->off = request.offset;
+        sqe->user_data = tag(slot);
+
+        m_sq_array[index] = index;
+        storeRelease(m_sq_tail, tail + 1);
+        ++m_pending;
+    }
+
+    void AsyncFileReader::submitCancel(size_t slot)
+    {
+        const u32 tail = *m_sq_tail;
+        const u32 index = tail & *m_sq_mask;
+
+        io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(m_sqes) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = tag(slot);
+        sqe->user_data = 0;
+
+        m_sq_array[index] = index;
+        storeRelease(m_sq_tail, tail + 1);
+        ++m_pending;
+    }
+
+    bool AsyncFileReader::enter(u32 wait)
+    {
+        for (;;)
+        {
+            const int result = int(::syscall(__NR_io_uring_enter, m_ring, m_pending, wait,
+                                             IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (result >= 0)
+            {
+                m_pending -= std::min(m_pending, u32(result));
+                return true;
+            }
+
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                return false;
+            }
+        }
+    }
+
+    AsyncFileReader::Status AsyncFileReader::read(u8* dst, size_t& offset, size_t size, const std::function<bool()>& abort)
+    {
+        if (m_ring < 0 || m_file < 0)
+        {
+            return Status::Failed;
+        }
+
+        ++m_generation;
+
+        const size_t first = offset;
+        const size_t chunks = (size - std::min(size, first) + m_request_size - 1) / m_request_size;
+
+        std::vector<u8> arrived(chunks, 0);
+        size_t next = 0;   // next chunk to submit
+        size_t prefix = 0; // chunks complete in file order
+        u32 inflight = 0;
+
+        Status status = Status::Complete;
+        bool unsupported = false;
+
+        auto cancelAll = [&]
+        {
+            for (size_t slot = 0; slot < m_requests.size(); ++slot)
+            {
+                if (m_requests[slot].busy)
+                {
+                    submitCancel(slot);
+                }
+            }
+        };
+
+        while (prefix < chunks || inflight)
+        {
+            if (status == Status::Complete)
+            {
+                if (abort())
+                {
+                    status = Status::Aborted;
+                    cancelAll();
+                }
+                else
+                {
+                    for (size_t slot = 0; slot < m_requests.size() && next < chunks; ++slot)
+                    {
+                        Request& request = m_requests[slot];
+                        if (request.busy)
+                        {
+                            continue;
+                        }
+
+                        const size_t begin = first + next * m_request_size;
+                        request.offset = begin;
+                        request.length = u32(std::min(m_request_size, size - begin));
+                        request.chunk = next++;
+                        request.busy = true;
+
+                        submitRead(slot, dst);
+                        ++inflight;
+                    }
+                }
+            }
+
+            if (!inflight)
+            {
+                break;
+            }
+
+            if (!enter(1))
+            {
+                // The ring is unusable; tearing it down cancels whatever is left.
+                destroy();
+                return Status::Failed;
+            }
+
+            u32 head = *m_cq_head;
+            const u32 tail = loadAcquire(m_cq_tail);
+
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = reinterpret_cast<const io_uring_cqe*>(m_cqes)[head & *m_cq_mask];
+
+                const size_t slot = size_t(cqe.user_data & 0xffff) - 1;
+                if (!(cqe.user_data & 0xffff) || (cqe.user_data >> 16) != m_generation || slot >= m_requests.size())
+                {
+                    // A cancel completion, or left over from an earlier read.
+                    continue;
+                }
+
+                Request& request = m_requests[slot];
+                const int result = cqe.res;
+
+                if (status == Status::Complete)
+                {
+                    if (result == -EINTR || result == -EAGAIN)
+                    {
+                        submitRead(slot, dst);
+                        continue;
+                    }
+
+                    if (result > 0 && u32(result) < request.length)
+                    {
+                        // Short read: ask for the rest.
+                        request.offset += u32(result);
+                        request.length -= u32(result);
+                        submitRead(slot, dst);
+                        continue;
+                    }
+                }
+
+                request.busy = false;
+                --inflight;
+
+                if (result > 0 && u32(result) == request.length)
+                {
+                    arrived[request.chunk] = 1;
+                }
+                else if (status == Status::Complete)
+                {
+                    // Error, or the file shrank under us.
+                    unsupported = result == -EINVAL;
+                    status = Status::Failed;
+                    cancelAll();
+                }
+            }
+
+            storeRelease(m_cq_head, head);
+
+            while (prefix < chunks && arrived[prefix])
+            {
+                ++prefix;
+            }
+        }
+
+        offset = std::min(size, std::max(offset, first + prefix * m_request_size));
+
+        if (unsupported)
+        {
+            // Kernel without IORING_OP_READ (before 5.6): stay on mappings from now on.
+            destroy();
+        }
+
+        return status;
+    }
+
+    bool isLocalFilesystem(const std::string& pathname)
+    {
+        struct statfs info;
+        if (::statfs(pathname.c_str(), &info) != 0)
+        {
+            return false;
+        }
+
+        switch (u32(info.f_type))
+        {
+            case 0x00006969: // NFS
+            case 0x0000517b: // SMB
+            case 0xff534d42: // CIFS
+            case 0xfe534d42: // SMB2
+            case 0x65735546: // FUSE
+            case 0x00c36400: // Ceph
+            case 0x01021997: // 9p
+            case 0x5346414f: // AFS
+            case 0x73757245: // Coda
+            case 0x0000564c: // NCP
+                return false;
+
+            default:
+                return true;
+        }
+    }
+
+    namespace
+    {
+
+        // First integer in a sysfs attribute; -1 when it cannot be read.
+        long readSysfsValue(const std::string& filename)
+        {
+            std::ifstream stream(filename);
+
+            long value = -1;
+            stream >> value;
+            return stream ? value : -1;
+        }
+
+    } // namespace
+
+    size_t deviceReadConcurrency(const std::string& pathname, size_t limit)
+    {
+        limit = std::max(size_t(1), limit);
+
+        struct statfs info;
+        if (::statfs(pathname.c_str(), &info) != 0)
+        {
+            return 1;
+        }
+
+        if (u32(info.f_type) == 0x01021994 || u32(info.f_type) == 0x858458f6) // tmpfs, ramfs
+        {
+            return limit;
+        }
+
+        const size_t shallow = std::min(limit, size_t(2));
+
+        struct stat status;
+        if (!isLocalFilesystem(pathname) || ::stat(pathname.c_str(), &status) != 0)
+        {
+            return shallow;
+        }
+
+        // A partition's queue attributes live with its parent disk.
+        const std::string device = "/sys/dev/block/" + std::to_string(major(status.st_dev)) +
+                                   ":" + std::to_string(minor(status.st_dev));
+
+        std::string queue = device + "/queue/";
+        long rotational = readSysfsValue(queue + "rotational");
+
+        if (rotational < 0)
+        {
+            queue = device + "/../queue/";
+            rotational = readSysfsValue(queue + "rotational");
+        }
+
+        if (rotational < 0)
+        {
+            // No block device behind it (btrfs subvolumes, overlayfs, ...).
+            return shallow;
+        }
+
+        if (rotational > 0)
+        {
+            return 1;
+        }
+
+        return readSysfsValue(queue + "nr_requests") >= 128 ? limit : shallow;
+    }
+
+    void adviseSequential(const void* address, size_t size)
+    {
+        // madvise() wants a page-aligned start.
+        const uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(address) + size;
+
+        ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_SEQUENTIAL);
+        ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+    }
+
+#else
+
+    bool isLocalFilesystem(const std::string& pathname)
+    {
+        MANGO_UNREFERENCED(pathname);
+        return false;
+    }
+
+    size_t deviceReadConcurrency(const std::string& pathname, size_t limit)
+    {
+        MANGO_UNREFERENCED(pathname);
+        MANGO_UNREFERENCED(limit);
+        return 1;
+    }
+
+    void adviseSequential(const void* address, size_t size)
+    {
+        MANGO_UNREFERENCED(address);
+        MANGO_UNREFERENCED(size);
+    }
+
+    AsyncFileReader::AsyncFileReader(u32 depth, size_t request_size)
+        : m_depth(depth)
+        , m_request_size(request_size)
+    {
+    }
+
+    AsyncFileReader::~AsyncFileReader()
+    {
+    }
+
+    void AsyncFileReader::destroy()
+    {
+    }
+
+    bool AsyncFileReader::open(const std::string& pathname, u64& size)
+    {
+        MANGO_UNREFERENCED(pathname);
+        MANGO_UNREFERENCED(size);
+        return false;
+    }
+
+    void AsyncFileReader::close()
+    {
+    }
+
+    AsyncFileReader::Status AsyncFileReader::read(u8* dst, size_t& offset, size_t size, const std::function<bool()>& abort)
+    {
+        MANGO_UNREFERENCED(dst);
+        MANGO_UNREFERENCED(offset);
+        MANGO_UNREFERENCED(size);
+        MANGO_UNREFERENCED(abort);
+        return Status::Failed;
+    }
+
+#endif
+
+} // namespace ifap
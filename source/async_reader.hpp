@@ -0,0 +1,110 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u8;
+    using mango::u32;
+    using mango::u64;
+
+    // Reads a native file into memory with several large reads in flight (io_uring,
+    // Linux only). A cold mapping faults one page at a time; this keeps the device
+    // queue busy instead. Not thread-safe: one reader per worker thread, one open file
+    // at a time. valid() is false when the ring cannot be created (non-Linux builds,
+    // io_uring disabled); callers then use a File mapping.
+    class AsyncFileReader
+    {
+    public:
+        enum class Status
+        {
+            Complete,
+            Aborted,
+            Failed, // unreadable, or the kernel lacks IORING_OP_READ; fall back to a mapping
+        };
+
+    protected:
+        struct Request
+        {
+            u64 offset = 0;  // file offset of the next byte to read
+            u32 length = 0;  // bytes still missing
+            size_t chunk = 0;
+            bool busy = false;
+        };
+
+        int m_ring = -1;
+        int m_file = -1;
+        u32 m_depth = 0;
+        size_t m_request_size = 0;
+
+        void* m_sq_memory = nullptr;
+        size_t m_sq_memory_size = 0;
+        void* m_cq_memory = nullptr;
+        size_t m_cq_memory_size = 0;
+        void* m_sqe_memory = nullptr;
+        size_t m_sqe_memory_size = 0;
+
+        u32* m_sq_head = nullptr;
+        u32* m_sq_tail = nullptr;
+        u32* m_sq_mask = nullptr;
+        u32* m_sq_array = nullptr;
+        u32* m_cq_head = nullptr;
+        u32* m_cq_tail = nullptr;
+        u32* m_cq_mask = nullptr;
+        void* m_sqes = nullptr;
+        void* m_cqes = nullptr;
+
+        std::vector<Request> m_requests;
+        u32 m_pending = 0;    // queued but not yet passed to io_uring_enter()
+        u64 m_generation = 0; // tags user_data so a late cancel cannot hit a later read
+
+        u64 tag(size_t slot) const;
+        void submitRead(size_t slot, u8* base);
+        void submitCancel(size_t slot);
+        bool enter(u32 wait);
+        void destroy();
+
+    public:
+        AsyncFileReader(u32 depth, size_t request_size);
+        ~AsyncFileReader();
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator = (const AsyncFileReader&) = delete;
+
+        bool valid() const
+        {
+            return m_ring >= 0;
+        }
+
+        bool open(const std::string& pathname, u64& size);
+        void close();
+
+        // Reads [offset, size) of the open file into dst + offset. On return, offset is
+        // the end of the contiguous prefix that arrived, so an aborted read can resume
+        // there. abort() is polled between completions; in-flight reads are then
+        // cancelled with IORING_OP_ASYNC_CANCEL.
+        Status read(u8* dst, size_t& offset, size_t size, const std::function<bool()>& abort);
+    };
+
+    // False for network and FUSE mounts (NFS, SMB/CIFS, Ceph, 9p, ...), where a mapping
+    // faults over the wire and a bulk copy is the better read. Always false off Linux.
+    bool isLocalFilesystem(const std::string& pathname);
+
+    // madvise(MADV_SEQUENTIAL | MADV_WILLNEED) over a file mapping; no-op off Linux.
+    void adviseSequential(const void* address, size_t size);
+
+    // How many reads are worth running at once against the device holding `pathname`,
+    // at most `limit`: one on rotational disks (seeks), all of them on tmpfs and on
+    // deep-queued (NVMe-class) devices, two on shallow-queued SSDs, network mounts and
+    // devices sysfs does not describe. Always one off Linux.
+    size_t deviceReadConcurrency(const std::string& pathname, size_t limit);
+
+} // namespace ifap
@@ -0,0 +1,355 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "block_pool.hpp"
+#include "context.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::image;
+
+    namespace
+    {
+
+        constexpr size_t huge_page_size = 2 * 1024 * 1024;
+        constexpr size_t block_granule = 64 * 1024;
+
+        // Eight classes per octave (at most 12.5% slack), rounded to whole huge pages
+        // once a block spans one.
+        size_t classSize(size_t size)
+        {
+            const size_t step = std::max(size_t(1), std::bit_floor(size) / 8);
+            size_t capacity = (size + step - 1) / step * step;
+
+            const size_t granule = capacity >= huge_page_size ? huge_page_size : block_granule;
+            capacity = (capacity + granule - 1) / granule * granule;
+
+            return capacity;
+        }
+
+        struct Block
+        {
+            u8* address = nullptr;
+            size_t capacity = 0;
+        };
+
+        class BlockPool
+        {
+        protected:
+            std::mutex m_mutex;
+            std::vector<Block> m_free; // oldest release first
+            size_t m_retained = 0;
+            u64 m_retain_limit = texture_pool_retained_bytes;
+
+            std::atomic<u64> m_allocated { 0 };
+            std::atomic<u64> m_reused { 0 };
+            std::atomic<u64> m_released { 0 };
+
+            static u8* map(size_t capacity)
+            {
+#if defined(__linux__)
+                // Over-map by a huge page and trim, so the block starts on a huge page
+                // boundary and khugepaged / the fault path can back it with 2 MB pages.
+                const size_t alignment = capacity >= huge_page_size ? huge_page_size : 0;
+                const size_t length = capacity + alignment;
+
+                void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (address == MAP_FAILED)
+                {
+                    throw std::bad_alloc();
+                }
+
+                uintptr_t begin = reinterpret_cast<uintptr_t>(address);
+
+                if (alignment)
+                {
+                    const uintptr_t aligned = (begin + alignment - 1) & ~uintptr_t(alignment - 1);
+                    const size_t head = aligned - begin;
+                    const size_t tail = length - head - capacity;
+
+                    if (head)
+                    {
+                        ::munmap(address, head);
+                    }
+
+                    if (tail)
+                    {
+                        ::munmap(reinterpret_cast<void*>(aligned + capacity), tail);
+                    }
+
+                    begin = aligned;
+                    ::madvise(reinterpret_cast<void*>(begin), capacity, MADV_HUGEPAGE);
+                }
+
+                return reinterpret_cast<u8*>(begin);
+#else
+                return new u8[capacity];
+#endif
+            }
+
+            static void unmap(const Block& block)
+            {
+#if defined(__linux__)
+                ::munmap(block.address, block.capacity);
+#else
+                delete[] block.address;
+#endif
+            }
+
+        public:
+            BlockPool()
+            {
+#if defined(__linux__)
+                const long pages = ::sysconf(_SC_PHYS_PAGES);
+                const long page_size = ::sysconf(_SC_PAGESIZE);
+
+                if (pages > 0 && page_size > 0)
+                {
+                    const u64 physical = u64(pages) * u64(page_size);
+                    m_retain_limit = std::min(m_retain_limit, physical / texture_pool_retained_divisor);
+                }
+#endif
+            }
+
+            u8* allocate(size_t capacity)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    // Most recently released first: its pages are the likeliest to be
+                    // resident.
+                    for (size_t i = m_free.size(); i-- > 0; )
+                    {
+                        if (m_free[i].capacity == capacity)
+                        {
+                            u8* address = m_free[i].address;
+                            m_free.erase(m_free.begin() + i);
+                            m_retained -= capacity;
+                            ++m_reused;
+                            return address;
+                        }
+                    }
+                }
+
+                ++m_allocated;
+                return map(capacity);
+            }
+
+            void release(u8* address, size_t capacity)
+            {
+                std::vector<Block> dropped;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    m_free.push_back({ address, capacity });
+                    m_retained += capacity;
+
+                    size_t count = 0;
+                    while (m_retained > m_retain_limit && count < m_free.size())
+                    {
+                        m_retained -= m_free[count].capacity;
+                        dropped.push_back(m_free[count]);
+                        ++count;
+                    }
+
+                    m_free.erase(m_free.begin(), m_free.begin() + count);
+                }
+
+                // munmap outside the lock; it can take a while for a large block.
+                for (const Block& block : dropped)
+                {
+                    unmap(block);
+                    ++m_released;
+                }
+            }
+
+            BlockPoolStats stats()
+            {
+                BlockPoolStats stats;
+                stats.allocated = m_allocated;
+                stats.reused = m_reused;
+                stats.released = m_released;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    stats.retained_bytes = m_retained;
+                }
+
+#if defined(__linux__)
+                rusage usage;
+                if (!::getrusage(RUSAGE_SELF, &usage))
+                {
+                    stats.minor_faults = u64(usage.ru_minflt);
+                }
+#endif
+
+                return stats;
+            }
+        };
+
+        // Never destroyed: blocks may be released by static objects during exit.
+        BlockPool& blockPool()
+        {
+            static BlockPool* pool = new BlockPool();
+            return *pool;
+        }
+
+    } // namespace
+
+    // -----------------------------------------------------------------------
+    // PooledBuffer
+    // -----------------------------------------------------------------------
+
+    PooledBuffer::PooledBuffer(size_t size)
+        : m_size(size)
+    {
+        if (size < texture_pool_min_size)
+        {
+            m_address = new u8[std::max(size, size_t(1))];
+        }
+        else
+        {
+            m_capacity = classSize(size);
+            m_address = blockPool().allocate(m_capacity);
+        }
+    }
+
+    PooledBuffer::PooledBuffer(size_t size, Sparse)
+        : m_size(size)
+    {
+#if defined(__linux__)
+        void* address = ::mmap(nullptr, std::max(size, size_t(1)), PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (address == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+        m_address = reinterpret_cast<u8*>(address);
+        m_sparse = true;
+#else
+        m_address = new u8[std::max(size, size_t(1))];
+#endif
+    }
+
+    PooledBuffer::~PooledBuffer()
+    {
+#if defined(__linux__)
+        if (m_sparse)
+        {
+            ::munmap(m_address, std::max(m_size, size_t(1)));
+            return;
+        }
+#endif
+
+        if (m_capacity)
+        {
+            blockPool().release(m_address, m_capacity);
+        }
+        else
+        {
+            delete[] m_address;
+        }
+    }
+
+    PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+        : m_address(std::exchange(other.m_address, nullptr))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_capacity(std::exchange(other.m_capacity, 0))
+        , m_sparse(std::exchange(other.m_sparse, false))
+    {
+    }
+
+    PooledBuffer& PooledBuffer::operator = (PooledBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            PooledBuffer previous(std::move(*this));
+            m_address = std::exchange(other.m_address, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_sparse = std::exchange(other.m_sparse, false);
+        }
+
+        return *this;
+    }
+
+    size_t PooledBuffer::discard(size_t offset, size_t size)
+    {
+        const size_t end = discardEnd(offset, size);
+
+#if defined(__linux__)
+        if (end > offset)
+        {
+            const uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+            const uintptr_t begin = (reinterpret_cast<uintptr_t>(m_address) + offset + page - 1) & ~(page - 1);
+            ::madvise(reinterpret_cast<void*>(begin), reinterpret_cast<uintptr_t>(m_address) + end - begin, MADV_DONTNEED);
+        }
+#endif
+
+        return end;
+    }
+
+    size_t PooledBuffer::discardEnd(size_t offset, size_t size) const
+    {
+#if defined(__linux__)
+        if (!m_sparse || offset >= m_size)
+        {
+            return offset;
+        }
+
+        const uintptr_t page = uintptr_t(::sysconf(_SC_PAGESIZE));
+        const uintptr_t base = reinterpret_cast<uintptr_t>(m_address);
+        const uintptr_t begin = (base + offset + page - 1) & ~(page - 1);
+        const uintptr_t end = (base + std::min(m_size, offset + size)) & ~(page - 1);
+
+        return begin < end ? size_t(end - base) : offset;
+#else
+        MANGO_UNREFERENCED(size);
+        return offset;
+#endif
+    }
+
+    // -----------------------------------------------------------------------
+    // PooledBitmap
+    // -----------------------------------------------------------------------
+
+    PooledBitmap::PooledBitmap(int width, int height, const Format& format)
+        : Surface(width, height, format, size_t(width) * format.bytes(), nullptr)
+        , m_buffer(stride * size_t(height))
+    {
+        image = m_buffer.data();
+    }
+
+    PooledBitmap::PooledBitmap(int width, int height, const Format& format, PooledBuffer::Sparse sparse)
+        : Surface(width, height, format, size_t(width) * format.bytes(), nullptr)
+        , m_buffer(stride * size_t(height), sparse)
+    {
+        image = m_buffer.data();
+    }
+
+    BlockPoolStats blockPoolStats()
+    {
+        return blockPool().stats();
+    }
+
+} // namespace ifap
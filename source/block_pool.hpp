@@ -0,0 +1,113 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+#include <mango/image/image.hpp>
+
+namespace ifap
+{
+    using mango::u8;
+    using mango::u64;
+
+    // Large blocks (file bytes, decode bitmaps) come from a process-wide pool of size
+    // classes instead of the heap: a released block is kept and handed to the next
+    // allocation of the same class, so paging through same-sized images neither maps
+    // nor faults in fresh memory. On Linux blocks are anonymous mappings advised for
+    // transparent huge pages. Free blocks above texture_pool_retained_bytes (capped
+    // by physical memory) are returned to the system, oldest first. Small sizes bypass
+    // the pool. Thread-safe.
+    class PooledBuffer
+    {
+    public:
+        // Address space only: pages are committed as they are written and can be handed
+        // back with discard(). Not pooled. A plain heap block off Linux.
+        struct Sparse {};
+
+    protected:
+        u8* m_address = nullptr;
+        size_t m_size = 0;
+        size_t m_capacity = 0; // size class; 0 for heap blocks
+        bool m_sparse = false;
+
+    public:
+        PooledBuffer() = default;
+        explicit PooledBuffer(size_t size);
+        PooledBuffer(size_t size, Sparse);
+        ~PooledBuffer();
+
+        PooledBuffer(PooledBuffer&& other) noexcept;
+        PooledBuffer& operator = (PooledBuffer&& other) noexcept;
+
+        PooledBuffer(const PooledBuffer&) = delete;
+        PooledBuffer& operator = (const PooledBuffer&) = delete;
+
+        u8* data()
+        {
+            return m_address;
+        }
+
+        const u8* data() const
+        {
+            return m_address;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        operator mango::ConstMemory () const
+        {
+            return mango::ConstMemory(m_address, m_size);
+        }
+
+        // Returns the whole pages inside [offset, offset + size) of a sparse buffer to
+        // the system; they read back as zero. Returns the page-aligned end of what was
+        // discarded (offset when nothing was), where a follow-up call can continue.
+        size_t discard(size_t offset, size_t size);
+
+        // What discard(offset, size) would return, without discarding anything.
+        size_t discardEnd(size_t offset, size_t size) const;
+    };
+
+    // Surface over a PooledBuffer; stands in for mango::image::Bitmap.
+    class PooledBitmap : public mango::image::Surface
+    {
+    protected:
+        PooledBuffer m_buffer;
+
+    public:
+        PooledBitmap(int width, int height, const mango::image::Format& format);
+        PooledBitmap(int width, int height, const mango::image::Format& format, PooledBuffer::Sparse);
+
+        // Sparse bitmaps only; byte range of the image (see PooledBuffer::discard).
+        size_t discard(size_t offset, size_t size)
+        {
+            return m_buffer.discard(offset, size);
+        }
+
+        size_t discardEnd(size_t offset, size_t size) const
+        {
+            return m_buffer.discardEnd(offset, size);
+        }
+
+        PooledBitmap(const PooledBitmap&) = delete;
+        PooledBitmap& operator = (const PooledBitmap&) = delete;
+    };
+
+    struct BlockPoolStats
+    {
+        u64 allocated = 0;      // blocks taken from the system
+        u64 reused = 0;         // allocations served from retained blocks
+        u64 released = 0;       // blocks given back to the system
+        u64 retained_bytes = 0; // free blocks currently kept
+        u64 minor_faults = 0;   // process minor page faults so far (Linux)
+    };
+
+    // Process-wide counters since startup.
+    BlockPoolStats blockPoolStats();
+
+} // namespace ifap
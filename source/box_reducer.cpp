@@ -0,0 +1,512 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "box_reducer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::image;
+
+    StreamingBoxReducer::StreamingBoxReducer(PooledBitmap& source, const Surface& dest, bool discard,
+                                             const ColorInfo* color)
+        : m_source(source)
+        , m_dest(dest)
+        , m_columns(size_t(dest.width) + 1)
+        , m_discard(discard)
+        , m_row_pixels(size_t(source.height), 0)
+        , m_row_pass(size_t(source.height), 0)
+        , m_row_state(size_t(dest.height), Pending)
+        , m_row_gone(size_t(source.height))
+    {
+        for (int x = 0; x <= dest.width; ++x)
+        {
+            m_columns[x] = u32(u64(x) * u64(source.width) / u64(dest.width));
+        }
+
+        if (dest.format.isFloat() && color)
+        {
+            m_linearize = true;
+            m_color = *color;
+        }
+
+        for (int y = 0; y < dest.height; ++y)
+        {
+            std::memset(m_dest.image + size_t(y) * m_dest.stride, 0, size_t(dest.width) * dest.format.bytes());
+        }
+    }
+
+    int StreamingBoxReducer::sourceRow(int dest_row) const
+    {
+        return int(u64(dest_row) * u64(m_source.height) / u64(m_dest.height));
+    }
+
+    int StreamingBoxReducer::destRow(int source_row) const
+    {
+        // The last destination row whose footprint starts at or above source_row, i.e.
+        // the one that contains it. Rounding down instead can name the row before,
+        // whose source rows may already have been discarded.
+        return int((u64(source_row + 1) * u64(m_dest.height) - 1) / u64(m_source.height));
+    }
+
+    void StreamingBoxReducer::rewind(int source_row)
+    {
+        // Only the destination rows over the rewritten row; more than one only when
+        // upscaling. One in flight finishes as Stale and is claimed again.
+        const int last = destRow(source_row);
+        int first = last;
+
+        while (first > 0 && sourceRow(first - 1) == source_row)
+        {
+            --first;
+        }
+
+        for (int dy = first; dy <= last; ++dy)
+        {
+            if (m_row_state[dy] == Done)
+            {
+                m_row_state[dy] = Pending;
+            }
+            else if (m_row_state[dy] == Claimed)
+            {
+                m_row_state[dy] = Stale;
+            }
+        }
+
+        if (first < m_next_row)
+        {
+            m_next_row = first;
+            m_ready.store(first, std::memory_order_release);
+            m_rewound = true;
+
+            // The rewritten rows are resident again; discard them once more when done.
+            m_discarded = std::min(m_discarded, size_t(sourceRow(first)) * m_source.stride);
+            ++m_rewinds;
+        }
+    }
+
+    bool StreamingBoxReducer::claimRows(int& begin, int& end, bool force)
+    {
+        // The first Pending row and the Pending rows after it whose source rows are
+        // all in (any Pending row with force); rows in flight are skipped. Source
+        // rows count as in once they are complete in the newest pass any of them has
+        // been written in, so a footprint a pass did not reach keeps its earlier data.
+        const int source_width = m_source.width;
+
+        int y = m_next_row;
+        while (y < m_dest.height && m_row_state[y] != Pending)
+        {
+            ++y;
+        }
+
+        begin = y;
+
+        for (; y < m_dest.height && m_row_state[y] == Pending; ++y)
+        {
+            const int s0 = sourceRow(y);
+            const int s1 = std::max(s0 + 1, sourceRow(y + 1));
+
+            u32 pass = 0;
+            for (int sy = s0; sy < s1; ++sy)
+            {
+                pass = std::max(pass, m_row_pass[sy]);
+            }
+
+            bool complete = true;
+
+            for (int sy = s0; sy < s1 && complete && !force; ++sy)
+            {
+                complete = m_row_pass[sy] == pass && m_row_pixels[sy] >= u32(source_width);
+            }
+
+            if (!complete)
+            {
+                break;
+            }
+
+            m_row_state[y] = Claimed;
+        }
+
+        end = y;
+
+        return begin < end;
+    }
+
+    void StreamingBoxReducer::completeRows(int begin, int end)
+    {
+        for (int y = begin; y < end; ++y)
+        {
+            m_row_state[y] = m_row_state[y] == Claimed ? Done : Pending;
+        }
+
+        const int next_row = m_next_row;
+
+        while (m_next_row < m_dest.height && m_row_state[m_next_row] == Done)
+        {
+            ++m_next_row;
+        }
+
+        if (m_next_row != next_row)
+        {
+            m_ready.store(m_next_row, std::memory_order_release);
+        }
+    }
+
+    void StreamingBoxReducer::reduceClaimed(int begin, int end, bool force)
+    {
+        std::unique_ptr<Scratch> scratch;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_scratch.empty())
+            {
+                scratch = std::move(m_scratch.back());
+                m_scratch.pop_back();
+            }
+        }
+
+        if (!scratch)
+        {
+            const size_t channels = size_t(m_source.width) * 4;
+
+            scratch = std::make_unique<Scratch>();
+
+            if (m_dest.format.isFloat())
+            {
+                scratch->linear_sums.resize(channels);
+                if (m_linearize)
+                {
+                    scratch->linear_row.resize(channels);
+                }
+            }
+            else
+            {
+                scratch->sums.resize(channels);
+            }
+        }
+
+        while (begin < end)
+        {
+            for (int y = begin; y < end; ++y)
+            {
+                reduceRow(y, *scratch);
+            }
+
+            size_t discard_begin = 0;
+            size_t discard_end = 0;
+            u32 rewinds = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                completeRows(begin, end);
+
+                // Source rows below the next destination row's footprint are done with,
+                // up to the first one the current pass has not rewritten yet: the decoder
+                // may be writing that one right now. One discard at a time; a later
+                // completion picks up what it missed.
+                if (m_discard && !m_discarding)
+                {
+                    const int limit = m_next_row < m_dest.height ? sourceRow(m_next_row) : m_source.height;
+                    int row = int(m_discarded / m_source.stride);
+
+                    while (row < limit && m_row_pass[row] == m_pass)
+                    {
+                        ++row;
+                    }
+
+                    discard_end = size_t(row) * m_source.stride;
+
+                    if (discard_end > m_discarded)
+                    {
+                        discard_begin = m_discarded;
+                        rewinds = m_rewinds;
+                        m_discarding = true;
+
+                        // Marked before the pages go, so a row a new pass starts writing
+                        // meanwhile is not taken for discarded.
+                        const size_t stride = m_source.stride;
+                        const size_t released = m_source.discardEnd(discard_begin, discard_end - discard_begin);
+
+                        for (size_t sy = discard_begin / stride; sy < (released + stride - 1) / stride; ++sy)
+                        {
+                            m_row_gone[sy].store(true, std::memory_order_relaxed);
+                        }
+                    }
+                }
+
+                if (!claimRows(begin, end, force))
+                {
+                    begin = end;
+                }
+
+                if (begin == end)
+                {
+                    m_scratch.push_back(std::move(scratch));
+                }
+            }
+
+            if (discard_end > discard_begin)
+            {
+                const size_t discarded = m_source.discard(discard_begin, discard_end - discard_begin);
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                // A rewind meanwhile lowered the mark; keep that.
+                if (m_rewinds == rewinds)
+                {
+                    m_discarded = discarded;
+                }
+
+                m_discarding = false;
+            }
+        }
+    }
+
+    void StreamingBoxReducer::reduceRow(int y, Scratch& scratch)
+    {
+        if (m_dest.format.isFloat())
+        {
+            reduceLinearRow(y, scratch);
+            return;
+        }
+
+        const int y0 = sourceRow(y);
+        const int y1 = std::max(y0 + 1, sourceRow(y + 1));
+        const size_t channels = size_t(m_source.width) * 4;
+
+        // Vertical pass: column sums over the footprint rows. Contiguous u8 -> u32
+        // widening adds, which the compiler turns into SIMD.
+        u32* sums = scratch.sums.data();
+        std::fill(sums, sums + channels, 0);
+
+        u32 rows = 0;
+
+        for (int sy = y0; sy < y1; ++sy)
+        {
+            if (m_row_gone[sy].load(std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            ++rows;
+            const u8* s = m_source.image + size_t(sy) * m_source.stride;
+
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += s[i];
+            }
+        }
+
+        // Every source row discarded: keep the previous reduction.
+        if (!rows)
+        {
+            return;
+        }
+
+        // Horizontal pass over the column sums.
+        u8* dest = m_dest.image + size_t(y) * m_dest.stride;
+
+        for (int x = 0; x < m_dest.width; ++x)
+        {
+            const u32 x0 = m_columns[x];
+            const u32 x1 = std::max(x0 + 1, m_columns[x + 1]);
+
+            u32 sum[4] = { 0, 0, 0, 0 };
+            const u32* s = sums + x0 * 4;
+
+            for (u32 sx = x0; sx < x1; ++sx)
+            {
+                sum[0] += s[0];
+                sum[1] += s[1];
+                sum[2] += s[2];
+                sum[3] += s[3];
+                s += 4;
+            }
+
+            const u32 count = rows * (x1 - x0);
+            for (int c = 0; c < 4; ++c)
+            {
+                dest[c] = u8((sum[c] + count / 2) / count);
+            }
+
+            dest += 4;
+        }
+    }
+
+    void StreamingBoxReducer::accumulateLinear(int source_row, float* sums, Scratch& scratch)
+    {
+        const size_t channels = size_t(m_source.width) * 4;
+        const u8* row = m_source.image + size_t(source_row) * m_source.stride;
+
+        if (m_linearize)
+        {
+            // Bake path: one row at a time into scene-linear fp16 (the same conversion
+            // the full-resolution path applies per decoded rect).
+            const Surface src(m_source, 0, source_row, m_source.width, 1);
+            const Surface dst(m_source.width, 1, m_dest.format, channels * sizeof(float16), scratch.linear_row.data());
+            linearize(dst, src, m_color);
+
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += float(scratch.linear_row[i]);
+            }
+
+            return;
+        }
+
+        if (m_source.format.isFloat() && m_source.format.bytes() == 16)
+        {
+            const float* s = reinterpret_cast<const float*>(row);
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += s[i];
+            }
+        }
+        else if (m_source.format.isFloat())
+        {
+            const float16* s = reinterpret_cast<const float16*>(row);
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += float(s[i]);
+            }
+        }
+        else if (m_source.format.bytes() == 8)
+        {
+            const u16* s = reinterpret_cast<const u16*>(row);
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += float(s[i]) * (1.0f / 65535.0f);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < channels; ++i)
+            {
+                sums[i] += float(row[i]) * (1.0f / 255.0f);
+            }
+        }
+    }
+
+    void StreamingBoxReducer::reduceLinearRow(int y, Scratch& scratch)
+    {
+        const int y0 = sourceRow(y);
+        const int y1 = std::max(y0 + 1, sourceRow(y + 1));
+
+        float* sums = scratch.linear_sums.data();
+        std::fill(scratch.linear_sums.begin(), scratch.linear_sums.end(), 0.0f);
+
+        u32 rows = 0;
+
+        for (int sy = y0; sy < y1; ++sy)
+        {
+            if (!m_row_gone[sy].load(std::memory_order_relaxed))
+            {
+                accumulateLinear(sy, sums, scratch);
+                ++rows;
+            }
+        }
+
+        if (!rows)
+        {
+            return;
+        }
+
+        float16* dest = reinterpret_cast<float16*>(m_dest.image + size_t(y) * m_dest.stride);
+
+        for (int x = 0; x < m_dest.width; ++x)
+        {
+            const u32 x0 = m_columns[x];
+            const u32 x1 = std::max(x0 + 1, m_columns[x + 1]);
+
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            const float* s = sums + x0 * 4;
+
+            for (u32 sx = x0; sx < x1; ++sx)
+            {
+                sum[0] += s[0];
+                sum[1] += s[1];
+                sum[2] += s[2];
+                sum[3] += s[3];
+                s += 4;
+            }
+
+            const float scale = 1.0f / float(rows * (x1 - x0));
+            for (int c = 0; c < 4; ++c)
+            {
+                dest[c] = float16(sum[c] * scale);
+            }
+
+            dest += 4;
+        }
+    }
+
+    void StreamingBoxReducer::consume(int x, int y, int width, int height)
+    {
+        const int source_width = m_source.width;
+        const int y0 = std::max(0, y);
+        const int y1 = std::min(m_source.height, y + height);
+        const u32 pixels = u32(std::clamp(x + width, 0, source_width) - std::clamp(x, 0, source_width));
+
+        if (y0 >= y1 || !pixels)
+        {
+            return;
+        }
+
+        int begin = 0;
+        int end = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (int sy = y0; sy < y1; ++sy)
+            {
+                // A row already complete in this pass is being written again: a new pass.
+                // Rows last written in an earlier pass start over as they arrive (in any
+                // order); only the destination rows over them wait for the new data.
+                if (m_row_pass[sy] == m_pass && m_row_pixels[sy] >= u32(source_width))
+                {
+                    ++m_pass;
+                }
+
+                if (m_row_pass[sy] != m_pass)
+                {
+                    m_row_pass[sy] = m_pass;
+                    m_row_pixels[sy] = 0;
+                    m_row_gone[sy].store(false, std::memory_order_relaxed);
+                    rewind(sy);
+                }
+
+                m_row_pixels[sy] += pixels;
+            }
+
+            if (!claimRows(begin, end, false))
+            {
+                return;
+            }
+        }
+
+        reduceClaimed(begin, end, false);
+    }
+
+    void StreamingBoxReducer::finish()
+    {
+        int begin = 0;
+        int end = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!claimRows(begin, end, true))
+            {
+                return;
+            }
+        }
+
+        reduceClaimed(begin, end, true);
+    }
+
+} // namespace ifap
@@ -0,0 +1,122 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+#include <mango/image/image.hpp>
+
+#include "block_pool.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u8;
+    using mango::u32;
+    using mango::float16;
+
+    // Area-averages a decode into a smaller RGBA surface while it streams in, so each
+    // decoded rect is reduced once instead of the whole image being resampled per
+    // preview. Once every source row under a destination row has arrived, that row is
+    // reduced; with a sparse source the source rows nothing else needs are discarded,
+    // so an image above the GPU texture limit never has to exist at full resolution
+    // and resident memory is the rows still in flight. A pass that rewrites rows
+    // already reduced (progressive formats, region passes) rewinds only the
+    // destination rows over them; the rest keep their reduction, and a discarded
+    // source row that was not rewritten is left out of a re-reduction instead of
+    // reading as black. Rows not reduced yet read as black. Thread-safe: the lock only covers the row
+    // bookkeeping; the consume() call that completes a destination row claims it and
+    // reduces (and discards) outside the lock, so concurrent decode threads reduce
+    // different rows in parallel.
+    //
+    // An 8-bit destination takes 8-bit sources and averages the encoded values. An
+    // fp16 destination averages in scene-linear space: fp16 / fp32 / 16-bit sources
+    // are summed as they are, or each row is linearize()d first when a colour
+    // conversion is given (the bake path).
+    class StreamingBoxReducer
+    {
+    protected:
+        enum RowState : u8
+        {
+            Pending, // waiting for its source rows
+            Claimed, // being reduced
+            Stale,   // being reduced, but rewound meanwhile: back to Pending when done
+            Done,
+        };
+
+        // Per-claimant buffers, kept for reuse.
+        struct Scratch
+        {
+            std::vector<u32> sums;              // per-channel column sums of one footprint
+            std::vector<float> linear_sums;     // the same, fp16 destination
+            std::vector<float16> linear_row;    // one linearize()d source row
+        };
+
+        PooledBitmap& m_source; // usually sparse
+        mango::image::Surface m_dest;
+        std::vector<u32> m_columns;    // source column where each destination column starts
+        bool m_linearize = false;
+        mango::image::ColorInfo m_color;
+        const bool m_discard;
+
+        // Guarded by m_mutex.
+        std::mutex m_mutex;
+        std::vector<u32> m_row_pixels; // decoded pixels per source row, in its pass
+        std::vector<u32> m_row_pass;   // pass each source row was last written in
+        u32 m_pass = 0;
+        std::vector<RowState> m_row_state; // per destination row
+        int m_next_row = 0;            // first destination row not Done
+        size_t m_discarded = 0;        // source bytes below this were discarded
+        bool m_discarding = false;
+        u32 m_rewinds = 0;
+        std::vector<std::unique_ptr<Scratch>> m_scratch;
+
+        // Per source row: released by a discard and not written since. Read by the
+        // reduction outside the lock.
+        std::vector<std::atomic<bool>> m_row_gone;
+
+        std::atomic<int> m_ready { 0 };
+        std::atomic<bool> m_rewound { false };
+
+        int sourceRow(int dest_row) const;
+        int destRow(int source_row) const;
+        void rewind(int source_row);
+        bool claimRows(int& begin, int& end, bool force);
+        void completeRows(int begin, int end);
+        void reduceClaimed(int begin, int end, bool force);
+        void reduceRow(int y, Scratch& scratch);
+        void reduceLinearRow(int y, Scratch& scratch);
+        void accumulateLinear(int source_row, float* sums, Scratch& scratch);
+
+    public:
+        // With discard off the source is left intact (it is wanted afterwards). color,
+        // for an fp16 destination only, converts source rows to scene-linear BT.709.
+        StreamingBoxReducer(PooledBitmap& source, const mango::image::Surface& dest, bool discard = true,
+                            const mango::image::ColorInfo* color = nullptr);
+
+        // Accounts for a decoded rect of the source.
+        void consume(int x, int y, int width, int height);
+
+        // The decode has finished: reduces whatever rows are still outstanding (a
+        // decoder that did not report every pixel) from the data that is there.
+        void finish();
+
+        // Destination rows [0, ready()) are final (until a rewind).
+        int ready() const
+        {
+            return m_ready.load(std::memory_order_acquire);
+        }
+
+        // True once after rows below ready() were invalidated by a rewind.
+        bool takeRewind()
+        {
+            return m_rewound.exchange(false);
+        }
+    };
+
+} // namespace ifap
@@ -0,0 +1,206 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "container_pool.hpp"
+#include "context.hpp"
+#include "filesystem_lock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::filesystem;
+
+    namespace
+    {
+
+        // Open containers kept per thread.
+        constexpr size_t path_cache_size = 4;
+
+    } // namespace
+
+    ContainerExtractPool::ContainerExtractPool(FileCache& file_cache, ContainerSlices& slices, size_t threads)
+        : m_file_cache(file_cache)
+        , m_slices(slices)
+    {
+        for (size_t i = 0; i < threads; ++i)
+        {
+            m_threads.emplace_back([this]
+            {
+                threadMain();
+            });
+        }
+    }
+
+    ContainerExtractPool::~ContainerExtractPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+            m_queue.clear();
+        }
+
+        m_cv.notify_all();
+        m_done_cv.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void ContainerExtractPool::request(std::vector<Job> jobs)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.clear();
+
+            for (Job& job : jobs)
+            {
+                if (!m_active.count(job.index))
+                {
+                    m_queue.push_back(std::move(job));
+                }
+            }
+        }
+
+        m_cv.notify_all();
+        m_done_cv.notify_all();
+    }
+
+    void ContainerExtractPool::clear()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.clear();
+        }
+
+        m_done_cv.notify_all();
+    }
+
+    bool ContainerExtractPool::contains(size_t index) const
+    {
+        if (m_active.count(index))
+        {
+            return true;
+        }
+
+        return std::any_of(m_queue.begin(), m_queue.end(), [index] (const Job& job)
+        {
+            return job.index == index;
+        });
+    }
+
+    bool ContainerExtractPool::wait(size_t index, const std::function<bool()>& abandoned)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (!contains(index))
+        {
+            return false;
+        }
+
+        while (contains(index))
+        {
+            if (!m_running || abandoned())
+            {
+                return false;
+            }
+
+            m_done_cv.wait_for(lock, std::chrono::milliseconds(20));
+        }
+
+        return true;
+    }
+
+    void ContainerExtractPool::threadMain()
+    {
+        std::vector<std::pair<std::string, std::unique_ptr<Path>>> paths; // most recent last
+
+        for (;;)
+        {
+            Job job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]
+                {
+                    return !m_running || !m_queue.empty();
+                });
+
+                if (!m_running)
+                {
+                    return;
+                }
+
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+                m_active.insert(job.index);
+            }
+
+            // Read by the prepare worker or an earlier request: put it back untouched.
+            FileCache::Entry cached = m_file_cache.take(job.index, job.pathname, job.stamp);
+
+            if (cached.complete())
+            {
+                m_file_cache.put(job.index, std::move(cached));
+            }
+            else if (texture_stored_slices && m_slices.find(job.container, job.member, job.stamp))
+            {
+                // Stored: nothing to inflate.
+            }
+            else
+            {
+                try
+                {
+                    auto it = std::find_if(paths.begin(), paths.end(), [&job] (const auto& entry)
+                    {
+                        return entry.first == job.container;
+                    });
+
+                    FilesystemLock lock(job.pathname, true);
+
+                    if (it == paths.end())
+                    {
+                        if (paths.size() >= path_cache_size)
+                        {
+                            paths.erase(paths.begin());
+                        }
+
+                        paths.emplace_back(job.container, std::make_unique<Path>(job.container + "/"));
+                    }
+                    else
+                    {
+                        std::rotate(it, it + 1, paths.end());
+                    }
+
+                    File file(*paths.back().second, job.member);
+                    const ConstMemory memory = file;
+
+                    auto buffer = std::make_unique<PooledBuffer>(memory.size);
+                    std::memcpy(buffer->data(), memory.address, memory.size);
+
+                    m_file_cache.put(job.index, { job.pathname, job.stamp, std::move(buffer), memory.size });
+                }
+                catch (...)
+                {
+                    // Unreadable member: the prepare worker reports it when it gets there.
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_active.erase(job.index);
+            }
+
+            m_done_cv.notify_all();
+        }
+    }
+
+} // namespace ifap
@@ -0,0 +1,76 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include "container_slice.hpp"
+#include "file_cache.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace ifap
+{
+    using mango::s64;
+
+    // Inflates ZIP members on several threads at once. ZIP entries are compressed
+    // independently, so the prefetch window inside one CBZ does not have to queue
+    // behind the single prepare worker. Results land in the FileCache, where the
+    // prepare worker takes them as complete entries. Each thread opens a container
+    // once as a Path of its own and keeps it for the next member, so the central
+    // directory is read once per archive per thread, and threads never share a mapper.
+    // Stored members are skipped; the prepare worker decodes them from a slice.
+    class ContainerExtractPool
+    {
+    public:
+        struct Job
+        {
+            size_t index;          // index position, the FileCache key
+            std::string pathname;  // full pathname, as the prepare worker builds it
+            std::string container; // native container file
+            std::string member;    // path inside the container
+            s64 stamp;             // container modification stamp
+        };
+
+    protected:
+        FileCache& m_file_cache;
+        ContainerSlices& m_slices;
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::condition_variable m_done_cv;
+        bool m_running = true;
+        std::deque<Job> m_queue;
+        std::unordered_set<size_t> m_active; // indices being extracted
+
+        void threadMain();
+        bool contains(size_t index) const;
+
+    public:
+        ContainerExtractPool(FileCache& file_cache, ContainerSlices& slices, size_t threads);
+        ~ContainerExtractPool();
+
+        ContainerExtractPool(const ContainerExtractPool&) = delete;
+        ContainerExtractPool& operator = (const ContainerExtractPool&) = delete;
+
+        // Replaces the queued jobs; `jobs` in priority order, the visible entry first.
+        // Extractions already running finish.
+        void request(std::vector<Job> jobs);
+        void clear();
+
+        // Waits while `index` is queued or being extracted. False when the pool had no
+        // job for it, or abandoned() fired first.
+        bool wait(size_t index, const std::function<bool()>& abandoned);
+    };
+
+} // namespace ifap
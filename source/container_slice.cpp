@@ -0,0 +1,370 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "container_slice.hpp"
+#include "async_reader.hpp"
+#include "directory_scanner.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::filesystem;
+
+    namespace
+    {
+
+        constexpr u64 iso_sector_size = 2048;
+        constexpr int iso_max_depth = 16;
+
+        u16 readLE16(const u8* p)
+        {
+            u16 value;
+            std::memcpy(&value, p, 2);
+            return value;
+        }
+
+        u32 readLE32(const u8* p)
+        {
+            u32 value;
+            std::memcpy(&value, p, 4);
+            return value;
+        }
+
+        std::string lowercase(std::string text)
+        {
+            for (char& c : text)
+            {
+                if (c >= 'A' && c <= 'Z')
+                {
+                    c = char(c - 'A' + 'a');
+                }
+            }
+
+            return text;
+        }
+
+        // ISO 9660 identifier to a plain name: UCS-2BE for Joliet, the ";1" version
+        // suffix and a trailing dot (no extension) removed.
+        std::string isoName(const u8* p, size_t length, bool joliet)
+        {
+            std::string name;
+
+            if (joliet)
+            {
+                for (size_t i = 0; i + 1 < length; i += 2)
+                {
+                    const u32 c = (u32(p[i]) << 8) | p[i + 1];
+
+                    if (c < 0x80)
+                    {
+                        name += char(c);
+                    }
+                    else if (c < 0x800)
+                    {
+                        name += char(0xc0 | (c >> 6));
+                        name += char(0x80 | (c & 0x3f));
+                    }
+                    else
+                    {
+                        name += char(0xe0 | (c >> 12));
+                        name += char(0x80 | ((c >> 6) & 0x3f));
+                        name += char(0x80 | (c & 0x3f));
+                    }
+                }
+            }
+            else
+            {
+                name.assign(reinterpret_cast<const char*>(p), length);
+            }
+
+            const size_t version = name.rfind(';');
+            if (version != std::string::npos)
+            {
+                name.resize(version);
+            }
+
+            if (!name.empty() && name.back() == '.')
+            {
+                name.pop_back();
+            }
+
+            return name;
+        }
+
+        struct IsoWalker
+        {
+            ConstMemory memory;
+            bool joliet;
+            std::unordered_map<std::string, std::pair<u64, u64>>& files; // key -> offset, size
+            std::unordered_set<u32> visited;
+
+            void walk(u32 extent, u32 size, const std::string& prefix, int depth)
+            {
+                const u64 begin = u64(extent) * iso_sector_size;
+                if (depth > iso_max_depth || !visited.insert(extent).second ||
+                    begin > memory.size || size > memory.size - begin)
+                {
+                    return;
+                }
+
+                const u8* data = memory.address + begin;
+
+                for (u64 offset = 0; offset < size; )
+                {
+                    const u8* p = data + offset;
+                    const u8 length = p[0];
+
+                    // Records never straddle a sector; zero fills the rest of one.
+                    if (!length)
+                    {
+                        offset = (offset / iso_sector_size + 1) * iso_sector_size;
+                        continue;
+                    }
+
+                    if (length < 34 || offset + length > size || 33 + size_t(p[32]) > length)
+                    {
+                        return;
+                    }
+
+                    const u32 child_extent = readLE32(p + 2);
+                    const u32 child_size = readLE32(p + 10);
+                    const u8 flags = p[25];
+                    const u8 name_length = p[32];
+
+                    offset += length;
+
+                    // "\0" and "\1" are the directory itself and its parent.
+                    if (name_length == 1 && p[33] <= 1)
+                    {
+                        continue;
+                    }
+
+                    const std::string name = prefix + isoName(p + 33, name_length, joliet);
+
+                    if (flags & 0x02)
+                    {
+                        walk(child_extent, child_size, name + "/", depth + 1);
+                    }
+                    else if (!(flags & 0x80)) // multi-extent files are not one range
+                    {
+                        files[lowercase(name)] = { u64(child_extent) * iso_sector_size, child_size };
+                    }
+                }
+            }
+        };
+
+        // Collects the files of an ISO 9660 image, through the Joliet tree when there
+        // is one (long names) and through the primary tree as well, so either naming
+        // finds the extent.
+        bool readIsoDirectory(ConstMemory memory, std::unordered_map<std::string, std::pair<u64, u64>>& files)
+        {
+            bool found = false;
+
+            for (u64 sector = 16; sector < 16 + 32; ++sector)
+            {
+                const u64 offset = sector * iso_sector_size;
+                if (offset + iso_sector_size > memory.size)
+                {
+                    break;
+                }
+
+                const u8* p = memory.address + offset;
+                if (std::memcmp(p + 1, "CD001", 5))
+                {
+                    break;
+                }
+
+                const u8 type = p[0];
+                if (type == 255)
+                {
+                    break;
+                }
+
+                const bool joliet = type == 2 && p[88] == '%' && p[89] == '/' &&
+                                    (p[90] == '@' || p[90] == 'C' || p[90] == 'E');
+
+                if (type == 1 || joliet)
+                {
+                    const u8* root = p + 156;
+                    IsoWalker walker { memory, joliet, files, {} };
+                    walker.walk(readLE32(root + 2), readLE32(root + 10), "", 0);
+                    found = true;
+                }
+            }
+
+            return found;
+        }
+
+    } // namespace
+
+    ContainerSlices::ContainerSlices(size_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    std::shared_ptr<ContainerSlices::Container> ContainerSlices::open(const std::string& container, s64 stamp)
+    {
+        auto result = std::make_shared<Container>();
+        result->pathname = container;
+        result->stamp = stamp;
+
+        if (!isLocalFilesystem(container))
+        {
+            return result;
+        }
+
+        const ContainerKind kind = containerKind(container);
+
+        if (kind == ContainerKind::Zip)
+        {
+            std::unordered_map<std::string, ZipMember> members;
+            if (!readZipDirectory(container, members))
+            {
+                return result;
+            }
+
+            for (auto& [name, member] : members)
+            {
+                if (member.stored)
+                {
+                    result->members[name] = { member.offset, member.compressed, true };
+                }
+            }
+
+            if (result->members.empty())
+            {
+                return result;
+            }
+        }
+        else if (kind != ContainerKind::Iso)
+        {
+            return result;
+        }
+
+        auto mapping = std::make_shared<File>(container);
+        const ConstMemory memory = *mapping;
+
+        if (kind == ContainerKind::Iso)
+        {
+            std::unordered_map<std::string, std::pair<u64, u64>> files;
+            if (!readIsoDirectory(memory, files))
+            {
+                return result;
+            }
+
+            for (auto& [name, range] : files)
+            {
+                result->members[name] = { range.first, range.second, false };
+            }
+        }
+
+        result->mapping = std::move(mapping);
+        return result;
+    }
+
+    ContainerSlices::Slice ContainerSlices::find(const std::string& container, const std::string& member, s64 stamp)
+    {
+        std::shared_ptr<Container> entry;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = std::find_if(m_containers.begin(), m_containers.end(), [&] (const auto& c)
+            {
+                return c->pathname == container;
+            });
+
+            if (it != m_containers.end() && (*it)->stamp == stamp)
+            {
+                m_containers.splice(m_containers.begin(), m_containers, it);
+                entry = m_containers.front();
+            }
+        }
+
+        if (!entry)
+        {
+            try
+            {
+                entry = open(container, stamp);
+            }
+            catch (...)
+            {
+                // Unreadable container: remembered as having nothing stored.
+                entry = std::make_shared<Container>();
+                entry->pathname = container;
+                entry->stamp = stamp;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_containers.remove_if([&] (const auto& c)
+            {
+                return c->pathname == container;
+            });
+
+            m_containers.push_front(entry);
+
+            if (m_containers.size() > m_capacity)
+            {
+                m_containers.pop_back();
+            }
+        }
+
+        if (!entry->mapping)
+        {
+            return {};
+        }
+
+        auto it = entry->members.find(member);
+        if (it == entry->members.end())
+        {
+            it = entry->members.find(lowercase(member));
+        }
+
+        if (it == entry->members.end())
+        {
+            return {};
+        }
+
+        const ConstMemory memory = *entry->mapping;
+        u64 offset = it->second.offset;
+        const u64 size = it->second.size;
+
+        if (it->second.zip)
+        {
+            // The data follows the local header, whose extra field may differ from the
+            // central directory's copy.
+            if (offset + 30 > memory.size || readLE32(memory.address + offset) != 0x04034b50)
+            {
+                return {};
+            }
+
+            const u8* local = memory.address + offset;
+            offset += 30 + readLE16(local + 26) + readLE16(local + 28);
+        }
+
+        if (offset > memory.size || size > memory.size - offset)
+        {
+            return {};
+        }
+
+        Slice slice;
+        slice.mapping = entry->mapping;
+        slice.memory = ConstMemory(memory.address + offset, size_t(size));
+        return slice;
+    }
+
+    void ContainerSlices::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_containers.clear();
+    }
+
+} // namespace ifap
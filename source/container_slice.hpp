@@ -0,0 +1,75 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ifap
+{
+    using mango::s64;
+    using mango::u64;
+
+    // Byte ranges of uncompressed members inside a native container: ZIP entries with
+    // method 0 (stored) and ISO 9660 files. Each container is mapped once and shared,
+    // so decoding such a member is a slice of that mapping, with no copy and no extra
+    // RAM per open image; the page cache is the only copy. Thread-safe.
+    class ContainerSlices
+    {
+    public:
+        struct Slice
+        {
+            std::shared_ptr<mango::filesystem::File> mapping; // keeps `memory` valid
+            mango::ConstMemory memory;
+
+            explicit operator bool () const
+            {
+                return mapping != nullptr;
+            }
+        };
+
+    protected:
+        struct Range
+        {
+            u64 offset = 0; // ZIP: local header; ISO: file data
+            u64 size = 0;
+            bool zip = false;
+        };
+
+        struct Container
+        {
+            std::string pathname;
+            s64 stamp = 0;
+            std::shared_ptr<mango::filesystem::File> mapping; // null: nothing stored
+            std::unordered_map<std::string, Range> members;   // lower-cased member path
+        };
+
+        size_t m_capacity;
+        std::mutex m_mutex;
+        std::list<std::shared_ptr<Container>> m_containers; // most recent first
+
+        std::shared_ptr<Container> open(const std::string& container, s64 stamp);
+
+    public:
+        explicit ContainerSlices(size_t capacity);
+
+        ContainerSlices(const ContainerSlices&) = delete;
+        ContainerSlices& operator = (const ContainerSlices&) = delete;
+
+        // Slice of `member` inside the native `container` with modification `stamp`;
+        // empty when the member is compressed, nested, or the container is not a local
+        // ZIP or ISO file.
+        Slice find(const std::string& container, const std::string& member, s64 stamp);
+
+        // Drops every mapping not held by a Slice.
+        void clear();
+    };
+
+} // namespace ifap
@@ -11,14 +11,40 @@
 
 namespace ifap
 {
-
-    // Serializes mango::filesystem access between the indexer thread and the texture
-    // worker (concurrent Path iteration + File::map is not safe on Windows).
-    // Recursive so the indexer can descend Path(parent, child) while holding the lock.
-    extern std::recursive_mutex filesystem_mutex;
+    using mango::u32;
     using mango::u64;
     using mango::math::float32x2;
 
+    // Keep watching indexed folders (inotify, Linux only) once the walk has finished, so
+    // files added, removed or renamed show up without reopening the folder.
+    static constexpr bool index_watch_folders = true;
+
+    // Watch-mode edits are written back to the index cache once the watched folders have
+    // been quiet for this long, and when the indexer stops.
+    static constexpr int index_cache_write_delay_ms = 2000;
+
+    // List plain local folders with the native directory scanner (getdents64, Linux only)
+    // instead of mango::filesystem::Path; containers always go through Path.
+    static constexpr bool index_native_scanner = true;
+
+    // Recursion policy for the walk. Plain folders and containers have separate depth
+    // limits; a container inside a container costs another container level. Entries past
+    // a depth limit are pruned.
+    static constexpr int index_max_folder_depth = 32;
+    static constexpr int index_max_container_depth = 3;
+
+    // Containers are published as a single placeholder entry and only opened when
+    // navigation gets close to it (ImageFileIndexer::expandNear). With this off they are
+    // opened during the walk until either budget below runs out; the rest are deferred
+    // the same way.
+    static constexpr bool index_lazy_containers = true;
+    static constexpr size_t index_max_open_containers = 256;
+    static constexpr u64 index_container_header_budget = 64 * 1024 * 1024;
+
+    // After the walk, parse the header of every native file on a low-priority thread
+    // (ImageFileIndexer::metadata), so sizes and formats are known before a file is opened.
+    static constexpr bool index_probe_headers = true;
+
     static constexpr size_t texture_cache_size = 16;
     static constexpr size_t texture_prefetch_size = 4;
 
@@ -27,11 +53,106 @@ namespace ifap
     // keeps the shared decode thread pool from thrashing across huge images.
     static constexpr size_t texture_inflight_decode_limit = 4;
 
+    // Decoded-bitmap bytes allowed in flight across decodes. Prefetch only applies this
+    // when the header probe knows the sizes; a single image may always exceed it.
+    static constexpr u64 texture_inflight_decode_bytes = 1024ull * 1024 * 1024;
+
+    // Images above the GPU texture limit are reduced to the preview size as rows arrive
+    // (32-bit RGBA decodes). With this on they decode into a sparse bitmap whose rows are
+    // handed back once reduced; off, the full-resolution bitmap stays resident.
+    static constexpr bool texture_streaming_downscale = true;
+
+    // Oversize images also keep their full-resolution decode (while the decodes kept
+    // stay under this many bytes; the visible image first, then the nearest) and show
+    // full detail when zoomed in through a tile atlas (see VirtualTexture).
+    static constexpr bool texture_virtual_tiles = true;
+    static constexpr u64 texture_virtual_source_bytes = 4096ull * 1024 * 1024;
+
+    // Atlas side in texels (clamped to the device limit) and slot side, which includes
+    // a filter border on each edge. At most this many tiles are uploaded per frame; an
+    // evicted slot must not have been drawn in this many recent frames (in flight).
+    static constexpr int texture_tile_atlas_size = 8192;
+    static constexpr int texture_tile_slot_size = 256;
+    static constexpr int texture_tile_border = 2;
+    static constexpr size_t texture_tile_uploads_per_frame = 16;
+    static constexpr u64 texture_tile_retire_frames = 3;
+
     // The worker reads each file into RAM in blocks of this size, checking for abort /
     // abandonment between blocks. This keeps a stale read (e.g. a huge file the user just
     // scrolled past) from holding the single worker thread until the whole file is read.
     static constexpr size_t texture_read_block_size = 8 * 1024 * 1024;
 
+    // Prepare lanes (threads reading files and launching decodes). 0 picks a count per
+    // backing device when a folder is opened (see deviceReadConcurrency): one on a
+    // spinning disk, up to the maximum on NVMe and tmpfs.
+    static constexpr size_t texture_prepare_lanes = 0;
+    static constexpr size_t texture_prepare_max_lanes = 4;
+
+    // Native files are read with io_uring (Linux): this many requests of this size in
+    // flight, instead of faulting a mapping in page by page. Abort is checked between
+    // completions. Containers and other platforms keep the block copy above. Off until
+    // it has been measured against the mapped copy on cold NVMe and spinning disks.
+    static constexpr bool texture_async_reads = false;
+    static constexpr u32 texture_read_queue_depth = 8;
+    static constexpr size_t texture_read_request_size = 2 * 1024 * 1024;
+
+    // Files at least this large on a local mount (Linux) are decoded straight from a
+    // retained mapping instead of a copy, so a big RAW or EXR is not held twice.
+    static constexpr bool texture_mapped_reads = true;
+    static constexpr size_t texture_mapped_read_min_size = 32 * 1024 * 1024;
+
+    // Mapped files start decoding once this much of the head is resident; the rest is
+    // prefaulted while the decode runs, and the decoder blocks in a page fault if it
+    // overtakes the reader.
+    static constexpr bool texture_streaming_decode = true;
+    static constexpr size_t texture_stream_head_size = 4 * 1024 * 1024;
+
+    // Compressed file bytes kept after their texture is released or evicted, so coming
+    // back decodes without I/O (least recently stored dropped first).
+    static constexpr u64 texture_file_cache_bytes = 512 * 1024 * 1024;
+
+    // Inside a solid RAR, members ahead of the view are extracted in order on a
+    // background thread into the file cache: up to this many members or bytes past the
+    // current one. The byte limit stays under the file cache budget so extracted
+    // members are not evicted before they are shown.
+    static constexpr size_t texture_solid_extract_count = 64;
+    static constexpr u64 texture_solid_extract_bytes = 256 * 1024 * 1024;
+
+    // The walk stops when a member costs this many times the best time per byte seen
+    // in the archive: the mapper is decompressing from the start on every open.
+    static constexpr double texture_solid_restart_ratio = 4.0;
+
+    // Threads inflating ZIP members (visible image first, then the prefetch window)
+    // into the file cache ahead of the prepare worker.
+    static constexpr size_t texture_zip_extract_threads = 3;
+
+    // Stored ZIP entries and ISO 9660 files (local mounts, Linux) are decoded from a
+    // slice of one shared mapping of their container instead of a copy. This many
+    // container mappings stay open.
+    static constexpr bool texture_stored_slices = true;
+    static constexpr size_t texture_slice_containers = 8;
+
+    // File buffers and decode bitmaps of at least this size come from the block pool
+    // (see PooledBuffer); up to this many bytes of released blocks are kept for reuse,
+    // and never more than this fraction of physical memory.
+    static constexpr size_t texture_pool_min_size = 1024 * 1024;
+    static constexpr u64 texture_pool_retained_bytes = 256 * 1024 * 1024;
+    static constexpr u64 texture_pool_retained_divisor = 32;
+
+    // The memory budgets above are separate and add up. Worst case, on top of the
+    // textures and the 16-entry texture cache:
+    //   texture_file_cache_bytes        512 MB  compressed bytes (solid extraction included)
+    //   texture_inflight_decode_bytes     1 GB  bitmaps of running decodes
+    //   texture_virtual_source_bytes      4 GB  finished oversize decodes kept for tiles
+    //   texture_pool_retained_bytes     256 MB  released blocks kept for reuse
+    // About 5.8 GB. The readahead lane only warms the page cache and is not counted.
+
+    // Readahead lane (Linux): page-cache hints for this many files in the navigation
+    // direction, up to this many bytes per navigation step. Far cheaper than a prepare,
+    // so it reaches well past the prefetch window.
+    static constexpr size_t texture_readahead_count = 32;
+    static constexpr u64 texture_readahead_bytes = 256 * 1024 * 1024;
+
     // Per-frame GPU upload budget. While the user is actively navigating we keep each
     // frame's copy/transfer small so input stays snappy; once they settle on an image
     // we push more bytes per frame so large images sharpen quickly.
@@ -0,0 +1,213 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "decode_scheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace ifap
+{
+
+    // -----------------------------------------------------------------------
+    // DecodeScheduler::Ticket
+    // -----------------------------------------------------------------------
+
+    DecodeScheduler::Ticket::~Ticket()
+    {
+        release();
+    }
+
+    DecodeScheduler::Ticket::Ticket(Ticket&& other) noexcept
+        : m_scheduler(other.m_scheduler)
+        , m_priority(other.m_priority)
+        , m_bytes(other.m_bytes)
+        , m_active(std::exchange(other.m_active, false))
+    {
+    }
+
+    DecodeScheduler::Ticket& DecodeScheduler::Ticket::operator = (Ticket&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+
+            m_scheduler = other.m_scheduler;
+            m_priority = other.m_priority;
+            m_bytes = other.m_bytes;
+            m_active = std::exchange(other.m_active, false);
+        }
+
+        return *this;
+    }
+
+    void DecodeScheduler::Ticket::release()
+    {
+        if (!m_scheduler)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_scheduler->m_mutex);
+
+            if (!m_active)
+            {
+                return;
+            }
+
+            m_active = false;
+            m_scheduler->remove(m_priority, m_bytes);
+        }
+
+        if (m_scheduler->m_on_release)
+        {
+            m_scheduler->m_on_release();
+        }
+    }
+
+    void DecodeScheduler::Ticket::setPriority(Priority priority)
+    {
+        if (!m_scheduler)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_scheduler->m_mutex);
+
+        if (m_active && m_priority != priority)
+        {
+            m_scheduler->remove(m_priority, m_bytes);
+            m_scheduler->add(priority, m_bytes);
+        }
+
+        m_priority = priority;
+    }
+
+    DecodeScheduler::Priority DecodeScheduler::Ticket::priority() const
+    {
+        if (!m_scheduler)
+        {
+            return m_priority;
+        }
+
+        std::lock_guard<std::mutex> lock(m_scheduler->m_mutex);
+        return m_priority;
+    }
+
+    void DecodeScheduler::Ticket::setBytes(u64 bytes)
+    {
+        if (!m_scheduler)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_scheduler->m_mutex);
+
+        if (m_active)
+        {
+            m_scheduler->remove(m_priority, m_bytes);
+            m_scheduler->add(m_priority, bytes);
+        }
+
+        m_bytes = bytes;
+    }
+
+    // -----------------------------------------------------------------------
+    // DecodeScheduler
+    // -----------------------------------------------------------------------
+
+    DecodeScheduler::DecodeScheduler(size_t decode_limit, u64 byte_budget, std::function<void()> on_release)
+        : m_decode_limit(std::max(size_t(1), decode_limit))
+        , m_byte_budget(byte_budget)
+        , m_on_release(std::move(on_release))
+    {
+    }
+
+    void DecodeScheduler::add(Priority priority, u64 bytes)
+    {
+        Occupancy& occupancy = m_occupancy[size_t(priority)];
+        ++occupancy.decodes;
+        occupancy.bytes += bytes;
+
+        ++m_decodes;
+        m_bytes += bytes;
+
+        if (priority == Priority::Visible)
+        {
+            ++m_visible;
+        }
+    }
+
+    void DecodeScheduler::remove(Priority priority, u64 bytes)
+    {
+        Occupancy& occupancy = m_occupancy[size_t(priority)];
+        --occupancy.decodes;
+        occupancy.bytes -= bytes;
+
+        --m_decodes;
+        m_bytes -= bytes;
+
+        if (priority == Priority::Visible)
+        {
+            --m_visible;
+        }
+    }
+
+    bool DecodeScheduler::admissible(Priority priority, u64 bytes) const
+    {
+        if (priority == Priority::Visible)
+        {
+            return true;
+        }
+
+        size_t limit = m_decode_limit;
+        u64 budget = m_byte_budget;
+
+        // Far prefetch only fills idle time, and only half the pipeline; while the
+        // visible image decodes, Near prefetch is held to half as well.
+        const bool visible = m_visible.load() > 0;
+
+        if (priority == Priority::Far && visible)
+        {
+            return false;
+        }
+
+        if (priority == Priority::Far || visible)
+        {
+            limit = std::max(size_t(1), limit / 2);
+            budget /= 2;
+        }
+
+        if (m_decodes.load() >= limit)
+        {
+            return false;
+        }
+
+        // A single image larger than the budget is still admitted on an idle pipeline.
+        const u64 active = m_bytes.load();
+        return !active || active + bytes <= budget;
+    }
+
+    DecodeScheduler::Ticket DecodeScheduler::admit(Priority priority, u64 bytes)
+    {
+        Ticket ticket;
+        ticket.m_scheduler = this;
+        ticket.m_priority = priority;
+        ticket.m_bytes = bytes;
+        ticket.m_active = true;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        add(priority, bytes);
+
+        return ticket;
+    }
+
+    DecodeScheduler::Occupancy DecodeScheduler::occupancy(Priority priority) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_occupancy[size_t(priority)];
+    }
+
+} // namespace ifap
@@ -0,0 +1,107 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace ifap
+{
+    using mango::u8;
+    using mango::u64;
+
+    // Admission and priority for decodes. Every task holds a Ticket from the moment it
+    // is requested until its decode has finished (or it is disposed), so the running
+    // totals are exact without walking the caches. Prefetch asks admissible() before
+    // requesting; the visible image is always admitted. mango's decode pool has no
+    // priorities and its threads are shared, so a running decode is never paused;
+    // prefetch gives way to the visible image by not being admitted (see
+    // admissible()). Prefetch decodes already running are not preempted: a visible
+    // decode started meanwhile shares the pool with them until they finish.
+    class DecodeScheduler
+    {
+    public:
+        enum class Priority : u8
+        {
+            Visible, // the image on screen
+            Near,    // first half of the prefetch window
+            Far,     // the rest; only runs while nothing visible is decoding
+        };
+
+        static constexpr size_t priority_count = 3;
+
+        struct Occupancy
+        {
+            size_t decodes = 0;
+            u64 bytes = 0;
+        };
+
+        class Ticket
+        {
+        protected:
+            friend class DecodeScheduler;
+
+            DecodeScheduler* m_scheduler = nullptr;
+            Priority m_priority = Priority::Far; // guarded by the scheduler's mutex
+            u64 m_bytes = 0;
+            bool m_active = false;
+
+        public:
+            Ticket() = default;
+            ~Ticket();
+
+            Ticket(Ticket&& other) noexcept;
+            Ticket& operator = (Ticket&& other) noexcept;
+
+            Ticket(const Ticket&) = delete;
+            Ticket& operator = (const Ticket&) = delete;
+
+            // Returns the ticket's share; safe to call more than once.
+            void release();
+
+            void setPriority(Priority priority);
+            Priority priority() const;
+
+            // Replaces the estimate once the header has been parsed.
+            void setBytes(u64 bytes);
+        };
+
+    protected:
+        const size_t m_decode_limit;
+        const u64 m_byte_budget;
+        std::function<void()> m_on_release;
+
+        mutable std::mutex m_mutex;
+        Occupancy m_occupancy[priority_count];
+
+        // Published totals for lock-free admission checks.
+        std::atomic<size_t> m_decodes { 0 };
+        std::atomic<u64> m_bytes { 0 };
+        std::atomic<size_t> m_visible { 0 };
+
+        void add(Priority priority, u64 bytes);
+        void remove(Priority priority, u64 bytes);
+
+    public:
+        // on_release runs (on any thread) whenever capacity frees up.
+        DecodeScheduler(size_t decode_limit, u64 byte_budget, std::function<void()> on_release);
+
+        DecodeScheduler(const DecodeScheduler&) = delete;
+        DecodeScheduler& operator = (const DecodeScheduler&) = delete;
+
+        // Would a decode of this class and estimated size (0 when unknown) fit now?
+        // While the visible image decodes, Near prefetch gets half the pipeline and
+        // Far none.
+        bool admissible(Priority priority, u64 bytes) const;
+
+        Ticket admit(Priority priority, u64 bytes);
+
+        Occupancy occupancy(Priority priority) const;
+    };
+
+} // namespace ifap
@@ -0,0 +1,559 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include <mango/image/decoder.hpp>
+#include "directory_scanner.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ifap
+{
+    using namespace mango;
+
+    namespace
+    {
+
+        // Extensions worth resolving without a probe. The table only stores the answer
+        // mango gives for each one, so listing something mango does not support is harmless.
+        const char* const common_extensions[] =
+        {
+            "jpg", "jpeg", "jpe", "jfif", "png", "apng", "gif", "bmp", "dib", "tga",
+            "tif", "tiff", "webp", "avif", "heic", "heif", "jxl", "jp2", "j2k", "jpc",
+            "exr", "hdr", "pic", "pnm", "pbm", "pgm", "ppm", "pam", "pfm", "psd",
+            "ico", "cur", "dds", "ktx", "ktx2", "pvr", "astc", "qoi", "iff", "ilbm",
+            "lbm", "pcx", "sgi", "rgb", "rgba", "bw", "dng", "cr2", "nef", "arw",
+            "orf", "rw2", "raw", "svg", "wbmp", "xbm", "xpm", "zip", "cbz", "rar",
+            "cbr", "7z", "cb7", "mgx", "snitch", "iso", "tar", "gz",
+            // frequent non-image neighbours
+            "txt", "json", "xml", "html", "md", "pdf", "mp4", "mkv", "mov", "avi",
+            "mp3", "flac", "wav", "nfo", "db", "ini", "log", "url", "exe", "dll",
+        };
+
+        // Extension packed into a u64 (at most eight bytes, case preserved); 0 = none
+        // or too long to pack.
+        u64 packExtension(std::string_view filename)
+        {
+            const size_t dot = filename.rfind('.');
+            if (dot == std::string_view::npos || dot + 1 == filename.size() || filename.size() - dot - 1 > 8)
+            {
+                return 0;
+            }
+
+            u64 key = 0;
+            for (size_t i = dot + 1; i < filename.size(); ++i)
+            {
+                key |= u64(u8(filename[i])) << ((i - dot - 1) * 8);
+            }
+            return key;
+        }
+
+        EntryClass probe(const std::string& filename)
+        {
+            // Containers first: the Path walk reports them as folders.
+            if (filesystem::Mapper::isCustomMapper(filename))
+            {
+                return EntryClass::Container;
+            }
+
+            const std::string extension = filesystem::getExtension(filename);
+            if (!extension.empty() && image::isImageDecoder(extension))
+            {
+                return EntryClass::Image;
+            }
+
+            return EntryClass::Other;
+        }
+
+        // Collision-free multiplicative hash over the known extensions: the multiplier
+        // is searched once at startup, so a lookup is one multiply, one shift and one
+        // key compare.
+        class ExtensionTable
+        {
+        protected:
+            u64 m_multiplier = 1;
+            int m_shift = 63;
+            std::vector<u64> m_keys;
+            std::vector<EntryClass> m_classes;
+
+            size_t slot(u64 key) const
+            {
+                return size_t((key * m_multiplier) >> m_shift);
+            }
+
+        public:
+            ExtensionTable()
+            {
+                std::vector<std::pair<u64, EntryClass>> entries;
+
+                for (const char* extension : common_extensions)
+                {
+                    const std::string filename = std::string("x.") + extension;
+                    entries.emplace_back(packExtension(filename), probe(filename));
+                }
+
+                u64 state = 0x9e3779b97f4a7c15ull;
+
+                for (int bits = 1; ; ++bits)
+                {
+                    if ((size_t(1) << bits) < entries.size() * 2)
+                    {
+                        continue;
+                    }
+
+                    for (int attempt = 0; attempt < 4096; ++attempt)
+                    {
+                        // splitmix64
+                        state += 0x9e3779b97f4a7c15ull;
+                        u64 z = state;
+                        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                        z ^= z >> 31;
+
+                        m_multiplier = z | 1;
+                        m_shift = 64 - bits;
+                        m_keys.assign(size_t(1) << bits, 0);
+                        m_classes.assign(size_t(1) << bits, EntryClass::Other);
+
+                        bool collision = false;
+
+                        for (const auto& [key, value] : entries)
+                        {
+                            const size_t index = slot(key);
+                            if (m_keys[index])
+                            {
+                                collision = true;
+                                break;
+                            }
+
+                            m_keys[index] = key;
+                            m_classes[index] = value;
+                        }
+
+                        if (!collision)
+                        {
+                            return;
+                        }
+                    }
+                }
+            }
+
+            bool lookup(u64 key, EntryClass& value) const
+            {
+                const size_t index = slot(key);
+                if (m_keys[index] != key)
+                {
+                    return false;
+                }
+
+                value = m_classes[index];
+                return true;
+            }
+        };
+
+    } // namespace
+
+    EntryClass classifyFilename(std::string_view filename)
+    {
+        static const ExtensionTable table;
+
+        const u64 key = packExtension(filename);
+        if (!key)
+        {
+            return probe(std::string(filename));
+        }
+
+        EntryClass value;
+        if (table.lookup(key, value))
+        {
+            return value;
+        }
+
+        // Uncommon (or differently cased) extension: ask mango once per walker thread.
+        thread_local std::unordered_map<u64, EntryClass> memo;
+
+        auto it = memo.find(key);
+        if (it == memo.end())
+        {
+            it = memo.emplace(key, probe(std::string(filename))).first;
+        }
+
+        return it->second;
+    }
+
+    namespace
+    {
+
+        struct ZipEndRecord
+        {
+            u32 directory_size = 0;
+            u32 directory_offset = 0;
+            u64 tail = 0; // bytes from the record to the end of the file
+        };
+
+        u16 readLE16(const char* p)
+        {
+            u16 value;
+            std::memcpy(&value, p, 2);
+            return value;
+        }
+
+        u32 readLE32(const char* p)
+        {
+            u32 value;
+            std::memcpy(&value, p, 4);
+            return value;
+        }
+
+        // Finds the ZIP end of central directory record: 22 bytes plus up to 64 KB of
+        // comment at the end of the file.
+        bool findZipEndRecord(std::ifstream& stream, u64 size, ZipEndRecord& record)
+        {
+            const size_t tail = size_t(std::min(size, u64(22 + 65535)));
+            if (tail < 22)
+            {
+                return false;
+            }
+
+            std::vector<char> buffer(tail);
+            stream.seekg(std::streamoff(size - tail));
+
+            if (!stream.read(buffer.data(), std::streamsize(tail)))
+            {
+                return false;
+            }
+
+            for (size_t i = tail - 22 + 1; i-- > 0; )
+            {
+                if (!std::memcmp(buffer.data() + i, "PK\x05\x06", 4))
+                {
+                    record.directory_size = readLE32(buffer.data() + i + 12);
+                    record.directory_offset = readLE32(buffer.data() + i + 16);
+                    record.tail = tail - i;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    } // namespace
+
+    u64 containerHeaderBytes(const std::string& filename)
+    {
+        const std::filesystem::path path = std::filesystem::u8path(filename);
+
+        std::error_code error;
+        const u64 size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return 0;
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+
+        ZipEndRecord record;
+        if (!findZipEndRecord(stream, size, record))
+        {
+            return std::min(size, u64(1) << 20);
+        }
+
+        return u64(record.directory_size) + record.tail;
+    }
+
+    bool isSolidRar(const std::string& filename)
+    {
+        std::ifstream stream(std::filesystem::u8path(filename), std::ios::binary);
+
+        char header[64] = {};
+        stream.read(header, sizeof(header));
+        const size_t size = size_t(stream.gcount());
+
+        if (size >= 7 + 5 && !std::memcmp(header, "Rar!\x1a\x07\x00", 7))
+        {
+            // RAR 4.x: main header (type 0x73) after the marker; MHD_SOLID = 0x0008.
+            const char* main = header + 7;
+            return u8(main[2]) == 0x73 && (readLE16(main + 3) & 0x0008);
+        }
+
+        if (size >= 8 && !std::memcmp(header, "Rar!\x1a\x07\x01\x00", 8))
+        {
+            // RAR 5.x: CRC32, then vints: header size, type (1 = main), header flags,
+            // optional extra and data sizes, archive flags (0x0004 = solid).
+            size_t offset = 8 + 4;
+
+            auto vint = [&] (u64& value) -> bool
+            {
+                value = 0;
+                for (int shift = 0; offset < size && shift < 64; shift += 7)
+                {
+                    const u8 byte = u8(header[offset++]);
+                    value |= u64(byte & 0x7f) << shift;
+                    if (!(byte & 0x80))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            u64 header_size, type, flags, value;
+            if (!vint(header_size) || !vint(type) || type != 1 || !vint(flags))
+            {
+                return false;
+            }
+
+            if ((flags & 0x0001) && !vint(value))
+            {
+                return false;
+            }
+
+            if ((flags & 0x0002) && !vint(value))
+            {
+                return false;
+            }
+
+            u64 archive_flags;
+            return vint(archive_flags) && (archive_flags & 0x0004);
+        }
+
+        return false;
+    }
+
+    ContainerKind containerKind(const std::string& filename)
+    {
+        std::ifstream stream(std::filesystem::u8path(filename), std::ios::binary);
+
+        char signature[4] = {};
+        stream.read(signature, sizeof(signature));
+
+        if (stream.gcount() == 4 && (!std::memcmp(signature, "PK\x03\x04", 4) || !std::memcmp(signature, "PK\x05\x06", 4)))
+        {
+            return ContainerKind::Zip;
+        }
+
+        // ISO 9660 volume descriptors start at sector 16.
+        char volume[6] = {};
+        stream.clear();
+        stream.seekg(16 * 2048);
+        stream.read(volume, sizeof(volume));
+
+        if (stream.gcount() == 6 && !std::memcmp(volume + 1, "CD001", 5))
+        {
+            return ContainerKind::Iso;
+        }
+
+        return isSolidRar(filename) ? ContainerKind::SolidRar : ContainerKind::Other;
+    }
+
+    bool readZipDirectory(const std::string& filename, std::unordered_map<std::string, ZipMember>& members)
+    {
+        const std::filesystem::path path = std::filesystem::u8path(filename);
+
+        std::error_code error;
+        const u64 size = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return false;
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+
+        ZipEndRecord record;
+        if (!findZipEndRecord(stream, size, record))
+        {
+            return false;
+        }
+
+        // ZIP64 archives keep the real values elsewhere; not worth it for a hint.
+        if (record.directory_offset == 0xffffffff ||
+            u64(record.directory_offset) + record.directory_size > size)
+        {
+            return false;
+        }
+
+        std::vector<char> directory(record.directory_size);
+        stream.seekg(std::streamoff(record.directory_offset));
+
+        if (!stream.read(directory.data(), std::streamsize(directory.size())))
+        {
+            return false;
+        }
+
+        for (size_t offset = 0; offset + 46 <= directory.size(); )
+        {
+            const char* p = directory.data() + offset;
+            if (readLE32(p) != 0x02014b50)
+            {
+                break;
+            }
+
+            const u16 flags = readLE16(p + 8);
+            const u16 method = readLE16(p + 10);
+            const u32 compressed = readLE32(p + 20);
+            const u32 uncompressed = readLE32(p + 24);
+            const u16 name_length = readLE16(p + 28);
+            const u16 extra_length = readLE16(p + 30);
+            const u16 comment_length = readLE16(p + 32);
+            const u32 local_offset = readLE32(p + 42);
+
+            if (offset + 46 + name_length > directory.size())
+            {
+                break;
+            }
+
+            // The local header repeats the name and carries its own extra field; allow
+            // for it instead of reading every local header.
+            ZipMember member;
+            member.offset = local_offset;
+            member.size = std::min(size - std::min(size, u64(local_offset)),
+                                   u64(compressed) + 30 + name_length + extra_length + 256);
+            member.compressed = compressed;
+            member.stored = method == 0 && !(flags & 0x0001) && compressed == uncompressed &&
+                            compressed != 0xffffffff;
+
+            members[std::string(p + 46, name_length)] = member;
+
+            offset += 46 + name_length + extra_length + comment_length;
+        }
+
+        return true;
+    }
+
+#if defined(__linux__)
+
+    namespace
+    {
+
+        struct LinuxDirent64
+        {
+            u64 d_ino;
+            s64 d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[1];
+        };
+
+    } // namespace
+
+    bool scanNativeDirectory(const std::string& pathname, NativeScan& scan, bool subfolders,
+                             const std::atomic<bool>& stop)
+    {
+        const int fd = ::open(pathname.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        alignas(8) char buffer[64 * 1024];
+
+        for (;;)
+        {
+            if (stop)
+            {
+                break;
+            }
+
+            const long bytes = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+            if (bytes < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                ::close(fd);
+                return false;
+            }
+
+            if (bytes == 0)
+            {
+                break;
+            }
+
+            for (long offset = 0; offset < bytes; )
+            {
+                const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+                offset += entry->d_reclen;
+
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+                {
+                    continue;
+                }
+
+                unsigned char type = entry->d_type;
+
+                if (type == DT_UNKNOWN || type == DT_LNK)
+                {
+                    // Follow symlinks like the Path walk does; dangling ones are skipped.
+                    struct stat info;
+                    if (::fstatat(fd, name, &info, 0) != 0)
+                    {
+                        continue;
+                    }
+
+                    type = S_ISDIR(info.st_mode) ? DT_DIR :
+                           S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+
+                if (type == DT_DIR)
+                {
+                    if (subfolders)
+                    {
+                        scan.subfolders.emplace_back(std::string(name) + "/", false);
+                    }
+                }
+                else if (type == DT_REG)
+                {
+                    switch (classifyFilename(name))
+                    {
+                        case EntryClass::Image:
+                            scan.images.emplace_back(name);
+                            break;
+
+                        case EntryClass::Container:
+                            if (subfolders)
+                            {
+                                scan.subfolders.emplace_back(std::string(name) + "/", true);
+                            }
+                            break;
+
+                        case EntryClass::Other:
+                            break;
+                    }
+                }
+            }
+        }
+
+        ::close(fd);
+        return true;
+    }
+
+#else
+
+    bool scanNativeDirectory(const std::string& pathname, NativeScan& scan, bool subfolders,
+                             const std::atomic<bool>& stop)
+    {
+        MANGO_UNREFERENCED(pathname);
+        MANGO_UNREFERENCED(scan);
+        MANGO_UNREFERENCED(subfolders);
+        MANGO_UNREFERENCED(stop);
+        return false;
+    }
+
+#endif
+
+} // namespace ifap
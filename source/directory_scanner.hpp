@@ -0,0 +1,80 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ifap
+{
+
+    enum class EntryClass : mango::u8
+    {
+        Other,
+        Image,     // mango::image::isImageDecoder() accepts the extension
+        Container, // mango::filesystem::Mapper opens the file as a folder
+    };
+
+    // Classifies a file name by extension, with the same answers as the isImageDecoder()
+    // and isCustomMapper() checks the Path walk does. Common extensions are resolved
+    // through a perfect-hash table built once at startup by probing mango. Anything else
+    // is probed once per thread and remembered. Thread-safe.
+    EntryClass classifyFilename(std::string_view filename);
+
+    struct NativeScan
+    {
+        std::vector<std::string> images;                          // basenames
+        std::vector<std::pair<std::string, bool>> subfolders;     // "name/", is container
+    };
+
+    // Estimated bytes mango reads to list the container file `filename` (a native path):
+    // the central directory plus the end record when it has a ZIP end record, otherwise
+    // the file size capped at 1 MB. 0 when the file cannot be read.
+    mango::u64 containerHeaderBytes(const std::string& filename);
+
+    // Where a ZIP member's bytes live in the container file: local header through
+    // compressed data (rounded up for the local extra field).
+    struct ZipMember
+    {
+        mango::u64 offset = 0;
+        mango::u64 size = 0;
+        mango::u64 compressed = 0; // compressed data bytes
+        bool stored = false;       // method 0, unencrypted: the data is the file itself
+    };
+
+    // True when the native file `filename` is a solid RAR (4.x or 5.x): members share one
+    // compressed stream, so extracting member n decompresses everything before it.
+    bool isSolidRar(const std::string& filename);
+
+    enum class ContainerKind : mango::u8
+    {
+        Other,
+        Zip,      // members compressed independently
+        Iso,      // ISO 9660: members are plain extents
+        SolidRar, // see isSolidRar()
+    };
+
+    // Sniffs the signature of the native container file `filename`.
+    ContainerKind containerKind(const std::string& filename);
+
+    // Reads the central directory of the ZIP file `filename` (a native path), keyed by
+    // member path. False when it is not a plain (non-ZIP64) ZIP.
+    bool readZipDirectory(const std::string& filename, std::unordered_map<std::string, ZipMember>& members);
+
+    // Lists a plain local directory with batched getdents64(). d_type avoids a stat per
+    // entry, and a stat is only needed for symlinks and filesystems that report
+    // DT_UNKNOWN. Subfolders are only collected when `subfolders` is set. Returns false
+    // when the directory cannot be read natively, or on non-Linux builds; the caller
+    // then falls back to mango::filesystem::Path.
+    bool scanNativeDirectory(const std::string& pathname, NativeScan& scan, bool subfolders,
+                             const std::atomic<bool>& stop);
+
+} // namespace ifap
@@ -0,0 +1,124 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "file_cache.hpp"
+
+namespace ifap
+{
+    using namespace mango;
+
+    FileCache::FileCache(u64 budget)
+        : m_budget(budget)
+    {
+    }
+
+    void FileCache::erase(std::unordered_map<size_t, Slot>::iterator it)
+    {
+        m_bytes -= it->second.entry.buffer->size();
+        m_order.erase(it->second.order);
+        m_slots.erase(it);
+    }
+
+    void FileCache::put(size_t index, Entry entry)
+    {
+        if (!entry.buffer || !entry.bytes || entry.buffer->size() > m_budget)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_slots.find(index);
+        if (it != m_slots.end())
+        {
+            erase(it);
+        }
+
+        // Partially filled entries are charged their full size: the buffer is allocated.
+        const size_t size = entry.buffer->size();
+
+        while (m_bytes + size > m_budget && !m_order.empty())
+        {
+            erase(m_slots.find(m_order.back()));
+        }
+
+        m_order.push_front(index);
+        m_slots.emplace(index, Slot { std::move(entry), m_order.begin() });
+        m_bytes += size;
+    }
+
+    FileCache::Entry FileCache::take(size_t index, const std::string& pathname, s64 stamp)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_slots.find(index);
+        if (it == m_slots.end())
+        {
+            return {};
+        }
+
+        Entry entry = std::move(it->second.entry);
+        m_bytes -= entry.buffer->size();
+        m_order.erase(it->second.order);
+        m_slots.erase(it);
+
+        if (entry.pathname != pathname || entry.stamp != stamp)
+        {
+            return {};
+        }
+
+        return entry;
+    }
+
+    void FileCache::remap(const std::function<size_t(size_t, const std::string&)>& remap)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::unordered_map<size_t, Slot> slots;
+        Order order;
+        m_bytes = 0;
+
+        // Oldest first, so a collision keeps the more recent entry.
+        for (auto it = m_order.rbegin(); it != m_order.rend(); ++it)
+        {
+            Slot& slot = m_slots.at(*it);
+
+            const size_t index = remap(*it, slot.entry.pathname);
+            if (index == size_t(-1))
+            {
+                continue;
+            }
+
+            auto previous = slots.find(index);
+            if (previous != slots.end())
+            {
+                m_bytes -= previous->second.entry.buffer->size();
+                order.erase(previous->second.order);
+                slots.erase(previous);
+            }
+
+            order.push_front(index);
+            m_bytes += slot.entry.buffer->size();
+            slots.emplace(index, Slot { std::move(slot.entry), order.begin() });
+        }
+
+        m_slots = std::move(slots);
+        m_order = std::move(order);
+    }
+
+    void FileCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slots.clear();
+        m_order.clear();
+        m_bytes = 0;
+    }
+
+    u64 FileCache::bytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+
+} // namespace ifap
@@ -0,0 +1,81 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include "block_pool.hpp"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ifap
+{
+    using mango::s64;
+    using mango::u64;
+
+    // Second tier below the texture cache: the compressed bytes of files whose textures
+    // were released or evicted, so decoding one again skips the read (and, inside a RAR
+    // or ISO, the extraction). A read abandoned half way is kept as a partially filled
+    // entry and resumed from there. Entries are keyed by index position, carry the full
+    // pathname and the modification stamp they were read at, and only match when both
+    // still agree. Least recently stored entries go first once the byte budget is
+    // exceeded. Thread-safe.
+    class FileCache
+    {
+    public:
+        struct Entry
+        {
+            std::string pathname;
+            s64 stamp = 0;
+            std::unique_ptr<PooledBuffer> buffer;
+            size_t bytes = 0; // valid prefix; buffer->size() when complete
+
+            bool complete() const
+            {
+                return buffer && bytes == buffer->size();
+            }
+        };
+
+    protected:
+        using Order = std::list<size_t>;
+
+        struct Slot
+        {
+            Entry entry;
+            Order::iterator order;
+        };
+
+        mutable std::mutex m_mutex;
+        std::unordered_map<size_t, Slot> m_slots;
+        Order m_order; // most recent first
+        u64 m_budget = 0;
+        u64 m_bytes = 0;
+
+        void erase(std::unordered_map<size_t, Slot>::iterator it);
+
+    public:
+        explicit FileCache(u64 budget);
+
+        // Stores (replaces) the bytes read for `index`. Entries larger than the budget
+        // are not kept.
+        void put(size_t index, Entry entry);
+
+        // Removes and returns the entry at `index` if it was read from `pathname` at
+        // `stamp`; an empty entry otherwise (a stale one is dropped).
+        Entry take(size_t index, const std::string& pathname, s64 stamp);
+
+        // Moves every entry to remap(index, pathname); size_t(-1) drops it.
+        void remap(const std::function<size_t(size_t, const std::string&)>& remap);
+
+        void clear();
+        u64 bytes() const;
+    };
+
+} // namespace ifap
@@ -0,0 +1,464 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "filename_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace ifap
+{
+    using namespace mango;
+
+    namespace
+    {
+        constexpr size_t arena_chunk_size = 256 * 1024;
+        constexpr size_t initial_block_slots = 16;
+
+        constexpr u64 fnv_basis = 0xcbf29ce484222325ull;
+        constexpr u64 fnv_prime = 0x100000001b3ull;
+
+        u64 hashAppend(u64 hash, std::string_view text)
+        {
+            for (char c : text)
+            {
+                hash = (hash ^ u8(c)) * fnv_prime;
+            }
+            return hash;
+        }
+
+        size_t roundUpPow2(size_t value)
+        {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    } // namespace
+
+    // -----------------------------------------------------------------------
+    // FilenameTable::View
+    // -----------------------------------------------------------------------
+
+    std::string FilenameTable::View::str() const
+    {
+        std::string result;
+        result.reserve(size());
+        result.append(folder);
+        result.append(name);
+        return result;
+    }
+
+    bool FilenameTable::View::operator == (std::string_view other) const
+    {
+        return other.size() == size() &&
+               other.substr(0, folder.size()) == folder &&
+               other.substr(folder.size()) == name;
+    }
+
+    // -----------------------------------------------------------------------
+    // FilenameTable
+    // -----------------------------------------------------------------------
+
+    FilenameTable::ReadGuard::ReadGuard(const FilenameTable& table)
+        : m_table(table)
+    {
+        // Register in the current epoch's slot; if a writer advanced the epoch in the
+        // meantime it may not be waiting for this slot, so register again.
+        for (;;)
+        {
+            const u32 epoch = table.m_epoch.load();
+            m_slot = epoch & 1;
+            table.m_readers[m_slot].fetch_add(1);
+
+            if (table.m_epoch.load() == epoch)
+            {
+                break;
+            }
+
+            table.m_readers[m_slot].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    FilenameTable::ReadGuard::~ReadGuard()
+    {
+        m_table.m_readers[m_slot].fetch_sub(1, std::memory_order_release);
+    }
+
+    FilenameTable::FilenameTable()
+    {
+        m_folder_blocks = std::make_unique<std::atomic<Folder*>[]>(folder_block_count);
+        m_snapshot = makeSnapshot(initial_block_slots);
+    }
+
+    FilenameTable::~FilenameTable()
+    {
+        delete m_snapshot.load();
+    }
+
+    FilenameTable::Snapshot* FilenameTable::makeSnapshot(size_t capacity) const
+    {
+        Snapshot* snapshot = new Snapshot();
+        snapshot->capacity = capacity;
+        snapshot->blocks = std::make_unique<std::atomic<Entry*>[]>(capacity);
+        return snapshot;
+    }
+
+    void FilenameTable::replaceSnapshot(Snapshot* next)
+    {
+        Snapshot* previous = m_snapshot.exchange(next);
+
+        // Readers that register from now on see `next`; wait out the ones that may
+        // still be looking at `previous`.
+        const u32 epoch = m_epoch.fetch_add(1);
+        while (m_readers[epoch & 1].load() != 0)
+        {
+            std::this_thread::yield();
+        }
+
+        delete previous;
+    }
+
+    FilenameTable::Folder FilenameTable::folderAt(u32 index) const
+    {
+        const Folder* block = m_folder_blocks[index >> block_bits].load(std::memory_order_acquire);
+        return block[index & (block_size - 1)];
+    }
+
+    FilenameTable::View FilenameTable::view(const Entry& entry) const
+    {
+        const Folder folder = folderAt(entry.folder);
+
+        View result;
+        result.folder = std::string_view(folder.data, folder.length);
+        result.name = entry.basename();
+        return result;
+    }
+
+    size_t FilenameTable::size() const
+    {
+        ReadGuard guard(*this);
+        return m_snapshot.load(std::memory_order_acquire)->count.load(std::memory_order_acquire);
+    }
+
+    FilenameTable::View FilenameTable::operator [] (size_t index) const
+    {
+        ReadGuard guard(*this);
+
+        const Snapshot* snapshot = m_snapshot.load(std::memory_order_acquire);
+        if (index >= snapshot->count.load(std::memory_order_acquire))
+        {
+            return {};
+        }
+
+        const Entry* block = snapshot->blocks[index >> block_bits].load(std::memory_order_acquire);
+        return view(block[index & (block_size - 1)]);
+    }
+
+    const char* FilenameTable::store(std::string_view text)
+    {
+        if (m_chunks.empty() || text.size() > m_chunk_size - m_chunk_used)
+        {
+            // Oversized strings get a chunk of their own.
+            m_chunk_size = std::max(arena_chunk_size, text.size());
+            m_chunks.emplace_back(new char[m_chunk_size]);
+            m_chunk_used = 0;
+            m_arena_bytes += m_chunk_size;
+        }
+
+        char* data = m_chunks.back().get() + m_chunk_used;
+        std::memcpy(data, text.data(), text.size());
+        m_chunk_used += text.size();
+        return data;
+    }
+
+    u32 FilenameTable::folder(std::string_view relative, bool copy)
+    {
+        auto it = m_folder_lookup.find(relative);
+        if (it != m_folder_lookup.end())
+        {
+            return it->second;
+        }
+
+        const u32 index = m_folder_count;
+        const size_t block = index >> block_bits;
+
+        if (block >= m_folder_storage.size())
+        {
+            m_folder_storage.emplace_back(new Folder[block_size]);
+            m_folder_blocks[block].store(m_folder_storage.back().get(), std::memory_order_release);
+        }
+
+        Folder& folder = m_folder_storage[block][index & (block_size - 1)];
+        folder.data = copy ? store(relative) : relative.data();
+        folder.length = u32(relative.size());
+
+        // Readers only reach a folder through an entry, which is published after this.
+        ++m_folder_count;
+        m_folder_lookup.emplace(std::string_view(folder.data, folder.length), index);
+
+        return index;
+    }
+
+    void FilenameTable::retain(std::shared_ptr<const void> owner)
+    {
+        m_retained.emplace_back(std::move(owner));
+    }
+
+    void FilenameTable::append(u32 folder, std::string_view name, bool copy)
+    {
+        Snapshot* snapshot = m_snapshot.load(std::memory_order_relaxed);
+        const size_t count = snapshot->count.load(std::memory_order_relaxed);
+        const size_t block = count >> block_bits;
+
+        if (block >= snapshot->capacity)
+        {
+            // Out of block slots: republish the same blocks in a larger table.
+            Snapshot* next = makeSnapshot(snapshot->capacity * 2);
+            for (size_t i = 0; i < snapshot->owners.size(); ++i)
+            {
+                next->blocks[i].store(snapshot->owners[i].get(), std::memory_order_relaxed);
+            }
+            next->owners = snapshot->owners;
+            next->count.store(count, std::memory_order_relaxed);
+
+            replaceSnapshot(next);
+            snapshot = next;
+        }
+
+        if (block >= snapshot->owners.size())
+        {
+            snapshot->owners.emplace_back(std::make_shared<Entry[]>(block_size));
+            snapshot->blocks[block].store(snapshot->owners.back().get(), std::memory_order_release);
+        }
+
+        Entry& entry = snapshot->owners[block][count & (block_size - 1)];
+        entry.folder = folder;
+        entry.length = u32(name.size());
+        entry.name = copy ? store(name) : name.data();
+
+        snapshot->count.store(count + 1, std::memory_order_release);
+    }
+
+    std::vector<FilenameTable::Entry> FilenameTable::entries() const
+    {
+        const Snapshot* snapshot = m_snapshot.load(std::memory_order_relaxed);
+        const size_t count = snapshot->count.load(std::memory_order_relaxed);
+
+        std::vector<Entry> result;
+        result.reserve(count);
+
+        for (size_t i = 0; i < count; i += block_size)
+        {
+            const Entry* block = snapshot->owners[i >> block_bits].get();
+            result.insert(result.end(), block, block + std::min(block_size, count - i));
+        }
+
+        return result;
+    }
+
+    void FilenameTable::publish(std::vector<Entry> entries)
+    {
+        const size_t blocks = (entries.size() + block_size - 1) >> block_bits;
+        Snapshot* next = makeSnapshot(std::max(initial_block_slots, roundUpPow2(blocks + 1)));
+
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            const size_t first = i << block_bits;
+            const size_t count = std::min(block_size, entries.size() - first);
+
+            next->owners.emplace_back(std::make_shared<Entry[]>(block_size));
+            std::copy(entries.begin() + first, entries.begin() + first + count, next->owners[i].get());
+            next->blocks[i].store(next->owners[i].get(), std::memory_order_relaxed);
+        }
+
+        next->count.store(entries.size(), std::memory_order_relaxed);
+        replaceSnapshot(next);
+    }
+
+    void FilenameTable::adopt(FilenameTable&& other)
+    {
+        // The strings stay where they are; only their owners move over.
+        m_chunks.insert(m_chunks.end(),
+            std::make_move_iterator(other.m_chunks.begin()),
+            std::make_move_iterator(other.m_chunks.end()));
+        m_retained.insert(m_retained.end(),
+            std::make_move_iterator(other.m_retained.begin()),
+            std::make_move_iterator(other.m_retained.end()));
+        m_arena_bytes += other.m_arena_bytes;
+
+        other.m_chunks.clear();
+        other.m_retained.clear();
+        other.m_chunk_used = 0;
+        other.m_chunk_size = 0;
+        other.m_arena_bytes = 0;
+
+        std::vector<u32> folders(other.m_folder_count);
+        for (u32 i = 0; i < other.m_folder_count; ++i)
+        {
+            const Folder source = other.folderAt(i);
+            folders[i] = folder(std::string_view(source.data, source.length), false);
+        }
+
+        std::vector<Entry> entries = other.entries();
+        for (Entry& entry : entries)
+        {
+            entry.folder = folders[entry.folder];
+        }
+
+        publish(std::move(entries));
+        other.clear();
+    }
+
+    bool FilenameTable::equals(const FilenameTable& other) const
+    {
+        const size_t count = size();
+        if (count != other.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const View a = (*this)[i];
+            const View b = other[i];
+
+            if (a.folder != b.folder || a.name != b.name)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void FilenameTable::clear()
+    {
+        replaceSnapshot(makeSnapshot(initial_block_slots));
+
+        for (size_t i = 0; i < m_folder_storage.size(); ++i)
+        {
+            m_folder_blocks[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        m_folder_storage.clear();
+        m_folder_lookup.clear();
+        m_folder_count = 0;
+
+        m_chunks.clear();
+        m_chunk_used = 0;
+        m_chunk_size = 0;
+        m_arena_bytes = 0;
+
+        m_retained.clear();
+    }
+
+    size_t FilenameTable::memoryUsage() const
+    {
+        const Snapshot* snapshot = m_snapshot.load(std::memory_order_relaxed);
+
+        return snapshot->owners.size() * block_size * sizeof(Entry) +
+               m_folder_storage.size() * block_size * sizeof(Folder) +
+               m_arena_bytes;
+    }
+
+    // -----------------------------------------------------------------------
+    // FilenameIndex
+    // -----------------------------------------------------------------------
+
+    FilenameIndex::FilenameIndex(const FilenameTable& table)
+        : m_table(table)
+    {
+    }
+
+    void FilenameIndex::clear()
+    {
+        m_slots = std::vector<u32>();
+        m_count = 0;
+    }
+
+    void FilenameIndex::place(size_t position, u64 hash)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t slot = size_t(hash) & mask;
+
+        while (m_slots[slot])
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        m_slots[slot] = u32(position + 1);
+    }
+
+    void FilenameIndex::grow()
+    {
+        std::vector<u32> previous = std::move(m_slots);
+        m_slots.assign(std::max(size_t(1024), previous.size() * 2), 0);
+
+        for (u32 value : previous)
+        {
+            if (value)
+            {
+                const FilenameTable::View name = m_table[value - 1];
+                place(value - 1, hashAppend(hashAppend(fnv_basis, name.folder), name.name));
+            }
+        }
+    }
+
+    void FilenameIndex::insert(size_t position)
+    {
+        // Keep the load factor at or below one half so probe runs stay short.
+        if ((m_count + 1) * 2 > m_slots.size())
+        {
+            grow();
+        }
+
+        const FilenameTable::View name = m_table[position];
+        place(position, hashAppend(hashAppend(fnv_basis, name.folder), name.name));
+        ++m_count;
+    }
+
+    void FilenameIndex::rebuild()
+    {
+        const size_t count = m_table.size();
+
+        m_slots.assign(roundUpPow2(std::max(size_t(1024), count * 2)), 0);
+        m_count = count;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const FilenameTable::View name = m_table[i];
+            place(i, hashAppend(hashAppend(fnv_basis, name.folder), name.name));
+        }
+    }
+
+    size_t FilenameIndex::find(std::string_view name) const
+    {
+        if (m_slots.empty())
+        {
+            return size_t(-1);
+        }
+
+        // The hash is over the full name, so it does not matter where the folder ends.
+        const size_t mask = m_slots.size() - 1;
+        size_t slot = size_t(hashAppend(fnv_basis, name)) & mask;
+
+        while (m_slots[slot])
+        {
+            const size_t position = m_slots[slot] - 1;
+            if (m_table[position] == name)
+            {
+                return position;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        return size_t(-1);
+    }
+
+} // namespace ifap
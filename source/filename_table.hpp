@@ -0,0 +1,185 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u32;
+
+    // Compact storage for the indexed file names. A name is a folder prefix, interned
+    // once per folder, plus a basename; both live in chunked arenas (or in retained
+    // external memory such as a mapped IndexCache) and never move, so a View stays
+    // valid until clear().
+    //
+    // Readers are lock-free: the entry table is published as a snapshot whose count
+    // only grows between rebuilds. A rebuild (publish(), or growing the block table)
+    // swaps in a new snapshot and retires the old one once no reader can still be
+    // inside it (two-slot epoch counter). All writer calls must be serialized by the
+    // caller.
+    class FilenameTable
+    {
+    public:
+        struct Entry
+        {
+            u32 folder = 0;
+            u32 length = 0;
+            const char* name = nullptr;
+
+            std::string_view basename() const
+            {
+                return std::string_view(name, length);
+            }
+        };
+
+        struct View
+        {
+            std::string_view folder;
+            std::string_view name;
+
+            size_t size() const
+            {
+                return folder.size() + name.size();
+            }
+
+            bool empty() const
+            {
+                return folder.empty() && name.empty();
+            }
+
+            std::string str() const;
+
+            bool operator == (std::string_view other) const;
+            bool operator != (std::string_view other) const
+            {
+                return !(*this == other);
+            }
+        };
+
+    protected:
+        static constexpr size_t block_bits = 12;
+        static constexpr size_t block_size = size_t(1) << block_bits;
+        static constexpr size_t folder_block_count = 4096;
+
+        struct Folder
+        {
+            const char* data = nullptr;
+            u32 length = 0;
+        };
+
+        struct Snapshot
+        {
+            size_t capacity = 0; // block slots
+            std::unique_ptr<std::atomic<Entry*>[]> blocks;
+            std::vector<std::shared_ptr<Entry[]>> owners; // writer side; shared on growth
+            std::atomic<size_t> count { 0 };
+        };
+
+        class ReadGuard
+        {
+        protected:
+            const FilenameTable& m_table;
+            u32 m_slot;
+
+        public:
+            explicit ReadGuard(const FilenameTable& table);
+            ~ReadGuard();
+        };
+
+        std::atomic<Snapshot*> m_snapshot { nullptr };
+        std::atomic<u32> m_epoch { 0 };
+        mutable std::atomic<u32> m_readers[2] {};
+
+        // Interned folder prefixes: fixed top-level table of stable blocks.
+        std::unique_ptr<std::atomic<Folder*>[]> m_folder_blocks;
+        std::vector<std::unique_ptr<Folder[]>> m_folder_storage;
+        std::unordered_map<std::string_view, u32> m_folder_lookup;
+        u32 m_folder_count = 0;
+
+        // String arena.
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        size_t m_chunk_used = 0;
+        size_t m_chunk_size = 0;
+        size_t m_arena_bytes = 0;
+
+        std::vector<std::shared_ptr<const void>> m_retained;
+
+        Snapshot* makeSnapshot(size_t capacity) const;
+        void replaceSnapshot(Snapshot* next);
+        Folder folderAt(u32 index) const;
+        View view(const Entry& entry) const;
+
+    public:
+        FilenameTable();
+        ~FilenameTable();
+
+        FilenameTable(const FilenameTable&) = delete;
+        FilenameTable& operator = (const FilenameTable&) = delete;
+
+        // reader side (any thread, lock-free)
+
+        size_t size() const;
+        View operator [] (size_t index) const;
+
+        // writer side
+
+        // Copies `text` into the arena.
+        const char* store(std::string_view text);
+
+        // Interns a folder prefix; with copy == false the caller guarantees the memory
+        // outlives the table (see retain()).
+        u32 folder(std::string_view relative, bool copy = true);
+
+        // Keeps external memory referenced by non-copied names alive until clear().
+        void retain(std::shared_ptr<const void> owner);
+
+        void append(u32 folder, std::string_view name, bool copy = true);
+
+        // Copy of the current entries for batched editing; publish() installs the result.
+        std::vector<Entry> entries() const;
+        void publish(std::vector<Entry> entries);
+
+        // Takes over another table's storage and entries (its folders are re-interned).
+        void adopt(FilenameTable&& other);
+
+        bool equals(const FilenameTable& other) const;
+
+        // Not safe against concurrent readers that still hold Views.
+        void clear();
+
+        // Approximate heap + arena footprint (entries, folders and owned strings).
+        size_t memoryUsage() const;
+    };
+
+    // Open-addressing name -> position index over a FilenameTable (4 bytes per slot).
+    // Not thread-safe; the indexer guards it with its own mutex.
+    class FilenameIndex
+    {
+    protected:
+        const FilenameTable& m_table;
+        std::vector<u32> m_slots; // position + 1; 0 = empty
+        size_t m_count = 0;
+
+        void grow();
+        void place(size_t position, mango::u64 hash);
+
+    public:
+        explicit FilenameIndex(const FilenameTable& table);
+
+        void clear();
+        void insert(size_t position);
+        void rebuild();
+        size_t find(std::string_view name) const;
+    };
+
+} // namespace ifap
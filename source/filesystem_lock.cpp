@@ -0,0 +1,108 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "filesystem_lock.hpp"
+#include "indexer.hpp"
+
+#include <atomic>
+#include <functional>
+
+namespace ifap
+{
+    using namespace mango;
+
+    namespace
+    {
+
+#if defined(_WIN32)
+        // Concurrent Path iteration + File::map is not safe on Windows; native paths share
+        // one shard there, which serializes the prepare lanes' file access.
+        constexpr bool serialize_native_paths = true;
+#else
+        constexpr bool serialize_native_paths = false;
+#endif
+
+        constexpr size_t shard_count = 64;
+
+        std::recursive_mutex shards[shard_count];
+
+        std::atomic<u64> acquired_count { 0 };
+        std::atomic<u64> contended_count { 0 };
+        std::atomic<u64> wait_total_us { 0 };
+
+        std::recursive_mutex* selectShard(const std::string& pathname, bool private_mapper)
+        {
+            if (private_mapper)
+            {
+                return serialize_native_paths ? &shards[0] : nullptr;
+            }
+
+            const size_t native = nativePathLength(pathname);
+            if (native == pathname.size())
+            {
+                return serialize_native_paths ? &shards[0] : nullptr;
+            }
+
+            if (serialize_native_paths)
+            {
+                // A container is mapped through the native filesystem as well.
+                return &shards[0];
+            }
+
+            // Keyed by the outermost container: nested archives are read through it.
+            const size_t hash = std::hash<std::string_view>()(std::string_view(pathname).substr(0, native));
+            return &shards[hash % shard_count];
+        }
+
+    } // namespace
+
+    FilesystemLock::FilesystemLock(const std::string& pathname)
+        : FilesystemLock(pathname, false)
+    {
+    }
+
+    FilesystemLock::FilesystemLock(const std::string& pathname, bool private_mapper)
+        : m_mutex(selectShard(pathname, private_mapper))
+    {
+        if (!m_mutex)
+        {
+            return;
+        }
+
+        ++acquired_count;
+
+        if (!m_mutex->try_lock())
+        {
+            const u64 time0 = Time::us();
+            m_mutex->lock();
+            m_wait_us = Time::us() - time0;
+
+            ++contended_count;
+            wait_total_us += m_wait_us;
+        }
+    }
+
+    FilesystemLock::~FilesystemLock()
+    {
+        if (m_mutex)
+        {
+            m_mutex->unlock();
+        }
+    }
+
+    bool FilesystemLock::locksNativePaths()
+    {
+        return serialize_native_paths;
+    }
+
+    FilesystemLockStats filesystemLockStats()
+    {
+        FilesystemLockStats stats;
+        stats.acquired = acquired_count;
+        stats.contended = contended_count;
+        stats.wait_us = wait_total_us;
+        return stats;
+    }
+
+} // namespace ifap
@@ -0,0 +1,60 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <mutex>
+#include <string>
+
+namespace ifap
+{
+    using mango::u64;
+
+    // Serializes mango::filesystem access per container file instead of process-wide.
+    // A container's mapper is not safe for concurrent Path iteration + File::map, so
+    // everything inside one archive shares a lock (picked by hashing the archive's
+    // native path into a fixed set of shards). Plain native paths take no lock, except
+    // on Windows, where every native mapping shares one shard. Recursive so the indexer
+    // can descend Path(parent, child) while holding it.
+    class FilesystemLock
+    {
+    protected:
+        std::recursive_mutex* m_mutex = nullptr;
+        u64 m_wait_us = 0;
+
+    public:
+        explicit FilesystemLock(const std::string& pathname);
+
+        // With private_mapper the caller reads through a Path it does not share with
+        // any other thread, so only the platform rule (Windows) applies.
+        FilesystemLock(const std::string& pathname, bool private_mapper);
+        ~FilesystemLock();
+
+        // True where native paths share a shard (Windows): a File mapped there is
+        // copied and unmapped under the lock as well.
+        static bool locksNativePaths();
+
+        FilesystemLock(const FilesystemLock&) = delete;
+        FilesystemLock& operator = (const FilesystemLock&) = delete;
+
+        // Time this acquisition spent blocked on another holder.
+        u64 waited() const
+        {
+            return m_wait_us;
+        }
+    };
+
+    struct FilesystemLockStats
+    {
+        u64 acquired = 0;  // lock acquisitions (native paths that need none are not counted)
+        u64 contended = 0; // acquisitions that found the shard held
+        u64 wait_us = 0;   // total time spent blocked
+    };
+
+    // Process-wide counters since startup.
+    FilesystemLockStats filesystemLockStats();
+
+} // namespace ifap
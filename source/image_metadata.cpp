@@ -0,0 +1,190 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include <mango/image/decoder.hpp>
+#include "context.hpp"
+#include "filesystem_lock.hpp"
+#include "image_metadata.hpp"
+#include "indexer.hpp"
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::image;
+
+    bool probeImageHeader(const std::string& pathname, ImageMetadata& metadata)
+    {
+        try
+        {
+            // Native paths only take a lock on Windows.
+            FilesystemLock lock(pathname);
+
+            // A mapping only pages in what the header parser touches.
+            filesystem::File file(pathname);
+            ConstMemory memory = file;
+
+            ImageDecoder decoder(memory, pathname);
+            if (!decoder.isDecoder())
+            {
+                return false;
+            }
+
+            const ImageHeader header = decoder.header();
+            if (header.width <= 0 || header.height <= 0)
+            {
+                return false;
+            }
+
+            metadata.valid = true;
+            metadata.width = u32(header.width);
+            metadata.height = u32(header.height);
+            metadata.format = header.format;
+            metadata.transfer = header.color.transfer;
+            metadata.primaries = header.color.primaries;
+            metadata.file_size = memory.size;
+            return true;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    void ImageMetadataTable::resize(size_t size)
+    {
+        m_state.resize(size, Unknown);
+        m_width.resize(size);
+        m_height.resize(size);
+        m_format.resize(size);
+        m_transfer.resize(size);
+        m_primaries.resize(size);
+        m_file_size.resize(size);
+    }
+
+    void ImageMetadataTable::insertRow(size_t position)
+    {
+        m_state.insert(m_state.begin() + position, Unknown);
+        m_width.insert(m_width.begin() + position, 0);
+        m_height.insert(m_height.begin() + position, 0);
+        m_format.insert(m_format.begin() + position, Format());
+        m_transfer.insert(m_transfer.begin() + position, 0);
+        m_primaries.insert(m_primaries.begin() + position, 0);
+        m_file_size.insert(m_file_size.begin() + position, 0);
+    }
+
+    void ImageMetadataTable::eraseRow(size_t position)
+    {
+        m_state.erase(m_state.begin() + position);
+        m_width.erase(m_width.begin() + position);
+        m_height.erase(m_height.begin() + position);
+        m_format.erase(m_format.begin() + position);
+        m_transfer.erase(m_transfer.begin() + position);
+        m_primaries.erase(m_primaries.begin() + position);
+        m_file_size.erase(m_file_size.begin() + position);
+    }
+
+    void ImageMetadataTable::clear()
+    {
+        resize(0);
+    }
+
+    void ImageMetadataTable::apply(const IndexEdit& edit)
+    {
+        // Rows beyond the table are implicitly unknown; only edits that reach into the
+        // stored range move anything.
+        switch (edit.type)
+        {
+            case IndexEdit::Type::Insert:
+                if (edit.position < m_state.size())
+                {
+                    insertRow(edit.position);
+                }
+                break;
+
+            case IndexEdit::Type::Erase:
+                if (edit.position < m_state.size())
+                {
+                    eraseRow(edit.position);
+                }
+                break;
+
+            case IndexEdit::Type::Move:
+            {
+                ImageMetadata metadata;
+                const bool probed = get(edit.position, metadata);
+                const bool failed = !probed && known(edit.position);
+
+                if (edit.position < m_state.size())
+                {
+                    eraseRow(edit.position);
+                }
+
+                if (edit.target <= m_state.size())
+                {
+                    insertRow(edit.target);
+                }
+
+                // A rename keeps the file's contents.
+                if (probed)
+                {
+                    set(edit.target, metadata);
+                }
+                else if (failed)
+                {
+                    fail(edit.target);
+                }
+                break;
+            }
+        }
+    }
+
+    void ImageMetadataTable::set(size_t index, const ImageMetadata& metadata)
+    {
+        if (index >= m_state.size())
+        {
+            resize(index + 1);
+        }
+
+        m_state[index] = Probed;
+        m_width[index] = metadata.width;
+        m_height[index] = metadata.height;
+        m_format[index] = metadata.format;
+        m_transfer[index] = u8(metadata.transfer);
+        m_primaries[index] = u8(metadata.primaries);
+        m_file_size[index] = metadata.file_size;
+    }
+
+    void ImageMetadataTable::fail(size_t index)
+    {
+        if (index >= m_state.size())
+        {
+            resize(index + 1);
+        }
+
+        m_state[index] = Failed;
+    }
+
+    bool ImageMetadataTable::known(size_t index) const
+    {
+        return index < m_state.size() && m_state[index] != Unknown;
+    }
+
+    bool ImageMetadataTable::get(size_t index, ImageMetadata& metadata) const
+    {
+        if (index >= m_state.size() || m_state[index] != Probed)
+        {
+            return false;
+        }
+
+        metadata.valid = true;
+        metadata.width = m_width[index];
+        metadata.height = m_height[index];
+        metadata.format = m_format[index];
+        metadata.transfer = TransferFunction(m_transfer[index]);
+        metadata.primaries = ColorPrimaries(m_primaries[index]);
+        metadata.file_size = m_file_size[index];
+        return true;
+    }
+
+} // namespace ifap
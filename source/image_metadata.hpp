@@ -0,0 +1,80 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ifap
+{
+    struct IndexEdit;
+
+    using mango::u8;
+    using mango::u32;
+    using mango::u64;
+
+    // What the background header probe learned about one indexed file.
+    struct ImageMetadata
+    {
+        bool valid = false;
+        u32 width = 0;
+        u32 height = 0;
+        mango::image::Format format;
+        mango::image::TransferFunction transfer = mango::image::TransferFunction::Unspecified;
+        mango::image::ColorPrimaries primaries = mango::image::ColorPrimaries::Unspecified;
+        u64 file_size = 0;
+
+        // Size of the decoded image at its native format.
+        u64 decodedBytes() const
+        {
+            return u64(width) * height * u64(std::max(1, format.bytes()));
+        }
+    };
+
+    // Parses just the image header of a native (non-container) file; false when the file
+    // cannot be opened or the header is not understood.
+    bool probeImageHeader(const std::string& pathname, ImageMetadata& metadata);
+
+    // Column-wise metadata for the indexed list, addressed by published position. Rows
+    // past the end, or never probed, read back as invalid. Not thread-safe; the indexer
+    // guards it.
+    class ImageMetadataTable
+    {
+    protected:
+        enum : u8
+        {
+            Unknown,
+            Probed,
+            Failed,
+        };
+
+        std::vector<u8> m_state;
+        std::vector<u32> m_width;
+        std::vector<u32> m_height;
+        std::vector<mango::image::Format> m_format;
+        std::vector<u8> m_transfer;
+        std::vector<u8> m_primaries;
+        std::vector<u64> m_file_size;
+
+        void resize(size_t size);
+        void insertRow(size_t position);
+        void eraseRow(size_t position);
+
+    public:
+        void clear();
+        void apply(const IndexEdit& edit);
+
+        void set(size_t index, const ImageMetadata& metadata);
+        void fail(size_t index);
+
+        // True when `index` was probed (successfully or not).
+        bool known(size_t index) const;
+        bool get(size_t index, ImageMetadata& metadata) const;
+    };
+
+} // namespace ifap
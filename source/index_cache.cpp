@@ -0,0 +1,414 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "index_cache.hpp"
+#include "indexer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ifap
+{
+    using namespace mango;
+
+    static constexpr u32 index_cache_magic = 0x50414649; // "IFAP"
+    static constexpr u32 index_cache_version = 2;
+
+    struct IndexCache::Header
+    {
+        u32 magic;
+        u32 version;
+        u32 root_length;
+        u32 folder_count;
+        u32 child_count;
+        u32 name_count;
+        u64 string_size;
+    };
+
+    struct IndexCache::FolderRecord
+    {
+        s64 stamp;
+        u32 path_offset;
+        u32 path_length;
+        u32 name_first;
+        u32 name_count;
+        u32 child_first;
+        u32 child_count;
+        u32 flags;
+        u32 reserved;
+    };
+
+    struct IndexCache::NameRecord
+    {
+        u32 folder;
+        u32 offset;
+        u32 length;
+    };
+
+    static_assert(sizeof(IndexCache::Header) % 8 == 0);
+    static_assert(sizeof(IndexCache::FolderRecord) % 8 == 0);
+
+    namespace
+    {
+        constexpr u32 folder_flag_archive = 1;
+        constexpr u32 folder_flag_lazy = 2;
+
+        constexpr size_t align8(size_t offset)
+        {
+            return (offset + 7) & ~size_t(7);
+        }
+
+        std::string cacheDirectory()
+        {
+#if defined(_WIN32)
+            if (const char* local = std::getenv("LOCALAPPDATA"); local && *local)
+            {
+                return std::string(local) + "/ifap/";
+            }
+#else
+            if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+            {
+                return std::string(xdg) + "/ifap/";
+            }
+
+            if (const char* home = std::getenv("HOME"); home && *home)
+            {
+                return std::string(home) + "/.cache/ifap/";
+            }
+#endif
+            return {};
+        }
+
+        std::string cacheFilename(const std::string& root)
+        {
+            const std::string directory = cacheDirectory();
+            if (directory.empty())
+            {
+                return {};
+            }
+
+            // FNV-1a of the root path; the root itself is stored in the file and compared
+            // on open, so a collision only costs a rescan.
+            u64 hash = 0xcbf29ce484222325ull;
+            for (char c : root)
+            {
+                hash = (hash ^ u8(c)) * 0x100000001b3ull;
+            }
+
+            return fmt::format("{}{:016x}.index", directory, hash);
+        }
+
+        // Layout: Header, root path, FolderRecord[], u32 children[], NameRecord[], strings.
+        struct Layout
+        {
+            size_t root;
+            size_t folders;
+            size_t children;
+            size_t names;
+            size_t strings;
+            size_t total;
+
+            Layout(size_t root_length, size_t folder_count, size_t child_count, size_t name_count, size_t string_size)
+            {
+                root = sizeof(IndexCache::Header);
+                folders = align8(root + root_length);
+                children = folders + folder_count * sizeof(IndexCache::FolderRecord);
+                names = align8(children + child_count * sizeof(u32));
+                strings = names + name_count * sizeof(IndexCache::NameRecord);
+                total = strings + string_size;
+            }
+        };
+
+    } // namespace
+
+    IndexCache::~IndexCache()
+    {
+    }
+
+    std::unique_ptr<IndexCache> IndexCache::open(const std::string& root)
+    {
+        const std::string filename = cacheFilename(root);
+        if (filename.empty())
+        {
+            return {};
+        }
+
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(std::filesystem::u8path(filename), error))
+        {
+            return {};
+        }
+
+        std::unique_ptr<IndexCache> cache(new IndexCache());
+
+        try
+        {
+            cache->m_file = std::make_unique<filesystem::File>(filename);
+        }
+        catch (...)
+        {
+            return {};
+        }
+
+        if (!cache->validate(root))
+        {
+            printLine(Print::Info, "IndexCache: discarding stale or damaged {}", filename);
+            return {};
+        }
+
+        return cache;
+    }
+
+    bool IndexCache::validate(const std::string& root)
+    {
+        ConstMemory memory = *m_file;
+
+        if (memory.size < sizeof(Header))
+        {
+            return false;
+        }
+
+        m_header = reinterpret_cast<const Header*>(memory.address);
+
+        if (m_header->magic != index_cache_magic || m_header->version != index_cache_version)
+        {
+            return false;
+        }
+
+        const Layout layout(m_header->root_length, m_header->folder_count,
+            m_header->child_count, m_header->name_count, m_header->string_size);
+
+        if (layout.total != memory.size || !m_header->folder_count)
+        {
+            return false;
+        }
+
+        const char* stored_root = reinterpret_cast<const char*>(memory.address + layout.root);
+        if (std::string_view(stored_root, m_header->root_length) != root)
+        {
+            return false;
+        }
+
+        m_folders = reinterpret_cast<const FolderRecord*>(memory.address + layout.folders);
+        m_children = reinterpret_cast<const u32*>(memory.address + layout.children);
+        m_names = reinterpret_cast<const NameRecord*>(memory.address + layout.names);
+        m_strings = reinterpret_cast<const char*>(memory.address + layout.strings);
+
+        // Bounds-check everything once so the accessors can trust the tables.
+        const u64 string_size = m_header->string_size;
+
+        for (u32 i = 0; i < m_header->folder_count; ++i)
+        {
+            const FolderRecord& record = m_folders[i];
+
+            if (u64(record.path_offset) + record.path_length > string_size ||
+                u64(record.name_first) + record.name_count > m_header->name_count ||
+                u64(record.child_first) + record.child_count > m_header->child_count)
+            {
+                return false;
+            }
+        }
+
+        for (u32 i = 0; i < m_header->child_count; ++i)
+        {
+            if (m_children[i] >= m_header->folder_count)
+            {
+                return false;
+            }
+        }
+
+        for (u32 i = 0; i < m_header->name_count; ++i)
+        {
+            const NameRecord& record = m_names[i];
+
+            if (record.folder >= m_header->folder_count ||
+                u64(record.offset) + record.length > string_size)
+            {
+                return false;
+            }
+        }
+
+        m_folder_lookup.reserve(m_header->folder_count);
+
+        for (u32 i = 0; i < m_header->folder_count; ++i)
+        {
+            const FolderRecord& record = m_folders[i];
+            m_folder_lookup.emplace(string(record.path_offset, record.path_length), i);
+        }
+
+        return true;
+    }
+
+    bool IndexCache::write(const std::string& root,
+                           const std::vector<FolderEntry>& folders,
+                           const std::vector<FilenameTable::Entry>& names)
+    {
+        const std::string filename = cacheFilename(root);
+        if (filename.empty() || folders.empty())
+        {
+            return false;
+        }
+
+        std::vector<FolderRecord> folder_records(folders.size());
+        std::vector<u32> children;
+        std::vector<NameRecord> name_records(names.size());
+        std::string strings;
+
+        for (size_t i = 0; i < folders.size(); ++i)
+        {
+            const FolderEntry& entry = folders[i];
+            FolderRecord& record = folder_records[i];
+
+            if (entry.first + entry.count > names.size())
+            {
+                return false;
+            }
+
+            record = FolderRecord {};
+            record.stamp = entry.stamp;
+            record.path_offset = u32(strings.size());
+            record.path_length = u32(entry.relative.size());
+            record.name_first = u32(entry.first);
+            record.name_count = u32(entry.count);
+            record.child_first = u32(children.size());
+            record.child_count = u32(entry.children.size());
+            record.flags = (entry.archive ? folder_flag_archive : 0) |
+                           (entry.lazy ? folder_flag_lazy : 0);
+
+            strings += entry.relative;
+            children.insert(children.end(), entry.children.begin(), entry.children.end());
+
+            // Names are stored without their folder's relative path.
+            for (size_t j = entry.first; j < entry.first + entry.count; ++j)
+            {
+                const std::string_view name = names[j].basename();
+
+                name_records[j].folder = u32(i);
+                name_records[j].offset = u32(strings.size());
+                name_records[j].length = u32(name.size());
+                strings.append(name);
+            }
+        }
+
+        if (strings.size() > 0xffffffffu)
+        {
+            return false;
+        }
+
+        Header header {};
+        header.magic = index_cache_magic;
+        header.version = index_cache_version;
+        header.root_length = u32(root.size());
+        header.folder_count = u32(folder_records.size());
+        header.child_count = u32(children.size());
+        header.name_count = u32(name_records.size());
+        header.string_size = strings.size();
+
+        const Layout layout(root.size(), folder_records.size(), children.size(),
+            name_records.size(), strings.size());
+
+        std::vector<char> image(layout.total, 0);
+        std::memcpy(image.data(), &header, sizeof(header));
+        std::memcpy(image.data() + layout.root, root.data(), root.size());
+        std::memcpy(image.data() + layout.folders, folder_records.data(), folder_records.size() * sizeof(FolderRecord));
+        std::memcpy(image.data() + layout.children, children.data(), children.size() * sizeof(u32));
+        std::memcpy(image.data() + layout.names, name_records.data(), name_records.size() * sizeof(NameRecord));
+        std::memcpy(image.data() + layout.strings, strings.data(), strings.size());
+
+        // Write next to the destination and rename over it, so a reader never maps a
+        // half-written file.
+        const std::filesystem::path target = std::filesystem::u8path(filename);
+        std::filesystem::path temp = target;
+        temp += ".tmp";
+
+        std::error_code error;
+        std::filesystem::create_directories(target.parent_path(), error);
+
+        {
+            std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+            if (!stream.write(image.data(), std::streamsize(image.size())))
+            {
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp, target, error);
+        if (error)
+        {
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    s64 IndexCache::stamp(const std::string& pathname)
+    {
+        const std::string native = pathname.substr(0, nativePathLength(pathname));
+
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(std::filesystem::u8path(native), error);
+        if (error)
+        {
+            return 0;
+        }
+
+        return s64(time.time_since_epoch().count());
+    }
+
+    std::string_view IndexCache::string(u32 offset, u32 length) const
+    {
+        return std::string_view(m_strings + offset, length);
+    }
+
+    size_t IndexCache::size() const
+    {
+        return m_header->name_count;
+    }
+
+    std::string_view IndexCache::name(size_t index) const
+    {
+        const NameRecord& record = m_names[index];
+        return string(record.offset, record.length);
+    }
+
+    size_t IndexCache::nameFolder(size_t index) const
+    {
+        return m_names[index].folder;
+    }
+
+    size_t IndexCache::folderCount() const
+    {
+        return m_header->folder_count;
+    }
+
+    IndexCache::Folder IndexCache::folder(size_t index) const
+    {
+        const FolderRecord& record = m_folders[index];
+
+        Folder folder;
+        folder.relative = string(record.path_offset, record.path_length);
+        folder.stamp = record.stamp;
+        folder.archive = (record.flags & folder_flag_archive) != 0;
+        folder.lazy = (record.flags & folder_flag_lazy) != 0;
+        folder.name_first = record.name_first;
+        folder.name_count = record.name_count;
+        folder.children = m_children + record.child_first;
+        folder.child_count = record.child_count;
+        return folder;
+    }
+
+    size_t IndexCache::find(std::string_view relative) const
+    {
+        auto it = m_folder_lookup.find(relative);
+        if (it == m_folder_lookup.end())
+        {
+            return size_t(-1);
+        }
+        return it->second;
+    }
+
+} // namespace ifap
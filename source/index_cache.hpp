@@ -0,0 +1,100 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include "filename_table.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u32;
+    using mango::s64;
+
+    // Memory-mapped snapshot of a finished index walk, one file per indexed root. It
+    // stores every walked folder with its modification stamp, so a later walk can take
+    // an unchanged folder's names and subfolders from here instead of iterating it.
+    //
+    // Folders are stored in depth-first walk order and own a contiguous range of the
+    // name table; names are stored relative to their folder.
+    class IndexCache
+    {
+    public:
+        // On-disk records, defined in index_cache.cpp.
+        struct Header;
+        struct FolderRecord;
+        struct NameRecord;
+
+    protected:
+        std::unique_ptr<mango::filesystem::File> m_file;
+
+        const Header* m_header = nullptr;
+        const FolderRecord* m_folders = nullptr;
+        const u32* m_children = nullptr;
+        const NameRecord* m_names = nullptr;
+        const char* m_strings = nullptr;
+
+        std::unordered_map<std::string_view, u32> m_folder_lookup;
+
+        IndexCache() = default;
+        bool validate(const std::string& root);
+        std::string_view string(u32 offset, u32 length) const;
+
+    public:
+        struct Folder
+        {
+            std::string_view relative; // folder path relative to the root, "" for the root
+            s64 stamp = 0;
+            bool archive = false;      // the folder entry itself is a container
+            bool lazy = false;         // unopened container, published as a placeholder
+            size_t name_first = 0;
+            size_t name_count = 0;
+            const u32* children = nullptr;
+            size_t child_count = 0;
+        };
+
+        // Input for write(): `first`/`count` select the folder's names from the entries
+        // passed alongside, `children` index into the folder list.
+        struct FolderEntry
+        {
+            std::string relative;
+            s64 stamp = 0;
+            bool archive = false;
+            bool lazy = false;
+            size_t first = 0;
+            size_t count = 0;
+            std::vector<u32> children;
+        };
+
+        ~IndexCache();
+
+        // Returns nullptr when there is no usable cache for the root.
+        static std::unique_ptr<IndexCache> open(const std::string& root);
+        static bool write(const std::string& root,
+                          const std::vector<FolderEntry>& folders,
+                          const std::vector<FilenameTable::Entry>& names);
+
+        // Modification stamp used to validate a cached folder; 0 when unknown. Folders
+        // inside a container are stamped with the container file.
+        static s64 stamp(const std::string& pathname);
+
+        // Name table: basenames (pointing into the mapping) and their owning folder.
+        size_t size() const;
+        std::string_view name(size_t index) const;
+        size_t nameFolder(size_t index) const;
+
+        size_t folderCount() const;
+        Folder folder(size_t index) const;
+        // Index of the folder with the given relative path, or -1.
+        size_t find(std::string_view relative) const;
+    };
+
+} // namespace ifap
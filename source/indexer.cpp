@@ -7,12 +7,76 @@
 #include <mango/core/system.hpp>
 #include <mango/image/decoder.hpp>
 #include "context.hpp"
+#include "directory_scanner.hpp"
+#include "filesystem_lock.hpp"
 #include "indexer.hpp"
 
+#include <chrono>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 namespace ifap
 {
     using namespace mango;
 
+    size_t nativePathLength(const std::string& pathname)
+    {
+        size_t start = 0;
+
+        while (start < pathname.size())
+        {
+            size_t end = pathname.find('/', start);
+            if (end == std::string::npos)
+            {
+                end = pathname.size();
+            }
+
+            if (end > start && end < pathname.size() &&
+                filesystem::Mapper::isCustomMapper(pathname.substr(start, end - start)))
+            {
+                return end;
+            }
+
+            start = end + 1;
+        }
+
+        return pathname.size();
+    }
+
+    size_t remapIndex(const IndexEdit& edit, size_t index)
+    {
+        switch (edit.type)
+        {
+            case IndexEdit::Type::Insert:
+                return index >= edit.position ? index + 1 : index;
+
+            case IndexEdit::Type::Erase:
+                if (index == edit.position)
+                {
+                    return size_t(-1);
+                }
+                return index > edit.position ? index - 1 : index;
+
+            case IndexEdit::Type::Move:
+                if (index == edit.position)
+                {
+                    return edit.target;
+                }
+                index = index > edit.position ? index - 1 : index;
+                return index >= edit.target ? index + 1 : index;
+        }
+
+        return index;
+    }
+
     // -----------------------------------------------------------------------
     // ImageFileIndexer
     // -----------------------------------------------------------------------
@@ -31,66 +95,406 @@ namespace ifap
         stop();
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_filenames.clear();
+            m_names.clear();
+            m_positions.clear();
+            m_changes = IndexChanges();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_metadata_mutex);
+            m_metadata.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_expand_mutex);
+            m_expanding.clear();
         }
+        m_pending.clear();
+        m_cache.reset();
+        m_listed = std::vector<FilenameTable::Entry>();
+        m_edited.clear();
+        m_editing = false;
+        m_order.clear();
+        m_root.reset();
     }
 
-    void ImageFileIndexer::folder(const Path& path, const std::string& prefix, int depth)
+    void ImageFileIndexer::folder(const std::shared_ptr<Path>& parent, Node* node)
     {
-        std::vector<std::string> names;
-        std::vector<std::pair<std::string, int>> subfolders;
+        std::vector<std::pair<std::string, bool>> subfolders;
+        std::shared_ptr<Path> path;
 
-        {
-            std::lock_guard<std::recursive_mutex> lock(filesystem_mutex);
+        node->stamp = IndexCache::stamp(m_prefix + node->relative);
 
-            for (auto& info : path)
+        if (!cachedFolder(node, subfolders) && !nativeFolder(node, subfolders))
+        {
+            try
             {
-                if (m_stop)
+                FilesystemLock lock(m_prefix + node->relative);
+
+                // Children of a cached or natively scanned folder have no parent Path;
+                // open them by name.
+                if (parent)
                 {
-                    return;
+                    path = std::make_shared<Path>(*parent, node->name);
                 }
+                else
+                {
+                    path = std::make_shared<Path>(m_prefix + node->relative);
+                }
+
+                scanFolder(*path, node, subfolders);
+            }
+            catch (...)
+            {
+                // Unreadable folder: publish it as empty (and never trust it from the
+                // cache) so the walk can move on.
+                node->names.clear();
+                node->stamp = 0;
+                subfolders.clear();
+                path.reset();
+            }
+
+            if (m_stop)
+            {
+                return;
+            }
+        }
+
+        // sort names; subfolders are sorted too so the published order does not depend
+        // on the directory iteration order of the underlying filesystem
+        std::sort(node->names.begin(), node->names.end());
+        std::sort(subfolders.begin(), subfolders.end());
+
+        node->children.reserve(subfolders.size());
+
+        for (const auto& [name, archive] : subfolders)
+        {
+            if (auto child = makeChild(node, name, archive))
+            {
+                node->children.emplace_back(std::move(child));
+            }
+        }
+
+        ++m_folder_count;
+
+        node->complete.store(true, std::memory_order_release);
+        publish(node);
+
+        // Depth-first: the recursion keeps the parent Path alive while a container
+        // child reads from its mapping.
+        for (auto& child : node->children)
+        {
+            if (m_stop)
+            {
+                return;
+            }
+
+            if (child->lazy)
+            {
+                publish(child.get());
+            }
+            else
+            {
+                folder(path, child.get());
+            }
+        }
+    }
+
+    std::unique_ptr<ImageFileIndexer::Node> ImageFileIndexer::makeChild(Node* parent, const std::string& name, bool archive)
+    {
+        // A container costs a container level, a plain folder a folder level.
+        const int depth = parent->depth + archive;
+        const int level = parent->level + !archive;
+
+        if (depth > index_max_container_depth || level > index_max_folder_depth)
+        {
+            ++m_pruned_count;
+            return {};
+        }
+
+        auto child = std::make_unique<Node>();
+        child->relative = parent->relative + name;
+        child->name = name;
+        child->depth = depth;
+        child->level = level;
+        child->archive = archive;
+        child->container = parent->container || archive;
+        child->parent = parent;
+
+        if (archive)
+        {
+            child->lazy = index_lazy_containers || !reserveContainer(child.get());
+
+            if (child->lazy)
+            {
+                // Nothing to walk: the placeholder is the node's only entry.
+                child->count = 1;
+                child->complete = true;
+                ++m_lazy_count;
+            }
+        }
+
+        return child;
+    }
+
+    u64 ImageFileIndexer::containerBytes(const Node* node) const
+    {
+        // Only a container file on the native filesystem can be inspected; one nested
+        // inside another container is charged a flat estimate.
+        const std::string pathname = m_prefix + node->relative;
+        const size_t native = nativePathLength(pathname);
+
+        return native + 1 == pathname.size() ?
+            containerHeaderBytes(pathname.substr(0, native)) : 64 * 1024;
+    }
+
+    bool ImageFileIndexer::reserveContainer(const Node* node)
+    {
+        // A reservation over budget is rolled back and the container stays lazy.
+        if (m_opened_containers.fetch_add(1) >= index_max_open_containers)
+        {
+            --m_opened_containers;
+            return false;
+        }
+
+        const u64 bytes = containerBytes(node);
+
+        if (m_header_bytes.fetch_add(bytes) >= index_container_header_budget)
+        {
+            m_header_bytes -= bytes;
+            --m_opened_containers;
+            return false;
+        }
+
+        return true;
+    }
+
+    void ImageFileIndexer::chargeContainer(const Node* node)
+    {
+        // An expansion the viewer asked for: counted, never refused.
+        ++m_opened_containers;
+        m_header_bytes += containerBytes(node);
+    }
+
+    bool ImageFileIndexer::cachedFolder(Node* node, std::vector<std::pair<std::string, bool>>& subfolders)
+    {
+        if (!m_cache || !node->stamp)
+        {
+            return false;
+        }
+
+        const size_t index = m_cache->find(node->relative);
+        if (index == size_t(-1))
+        {
+            return false;
+        }
+
+        // A container that was only a placeholder last time has no names to reuse.
+        const IndexCache::Folder folder = m_cache->folder(index);
+        if (folder.stamp != node->stamp || folder.lazy)
+        {
+            return false;
+        }
+
+        // publish() appends the names straight from the mapping.
+        node->cached = index;
+
+        for (size_t i = 0; i < folder.child_count; ++i)
+        {
+            const IndexCache::Folder child = m_cache->folder(folder.children[i]);
+            std::string_view name = child.relative;
+            name.remove_prefix(std::min(name.size(), folder.relative.size()));
+            subfolders.emplace_back(std::string(name), child.archive);
+        }
+
+        ++m_cached_count;
+        return true;
+    }
+
+    bool ImageFileIndexer::nativeFolder(Node* node, std::vector<std::pair<std::string, bool>>& subfolders)
+    {
+        if (!index_native_scanner || node->container)
+        {
+            return false;
+        }
+
+        NativeScan scan;
+        if (!scanNativeDirectory(m_prefix + node->relative, scan, true, m_stop))
+        {
+            return false;
+        }
+
+        node->names = std::move(scan.images);
+        subfolders = std::move(scan.subfolders);
+        return true;
+    }
+
+    void ImageFileIndexer::scanFolder(const Path& path, Node* node, std::vector<std::pair<std::string, bool>>& subfolders)
+    {
+        for (auto& info : path)
+        {
+            if (m_stop)
+            {
+                return;
+            }
+
+            bool encrypted = info.isEncrypted();
+            if (encrypted)
+            {
+                continue;
+            }
 
-                bool encrypted = info.isEncrypted();
-                if (encrypted)
+            if (!info.isDirectory())
+            {
+                if (classifyFilename(info.name) == EntryClass::Image)
                 {
-                    continue;
+                    node->names.emplace_back(info.name);
                 }
+            }
+            else
+            {
+                // makeChild() applies the recursion policy.
+                subfolders.emplace_back(info.name, info.isContainer());
+            }
+        }
+    }
+
+    void ImageFileIndexer::publish(Node* node)
+    {
+        node->first = m_published;
+        node->count = node->lazy ? 1 : node->cached != size_t(-1) ?
+            m_cache->folder(node->cached).name_count : node->names.size();
+
+        if (!node->count)
+        {
+            return;
+        }
 
-                if (!info.isDirectory())
+        m_published += node->count;
+
+        auto append = [this] (FilenameTable& table, Node* node, auto&& added)
+        {
+            if (node->lazy)
+            {
+                table.append(table.folder(node->relative), std::string_view());
+                added();
+            }
+            else if (node->cached != size_t(-1))
+            {
+                // Zero-copy: the table retains the mapping (see start()).
+                const IndexCache::Folder folder = m_cache->folder(node->cached);
+                const u32 id = table.folder(folder.relative, false);
+
+                for (size_t i = 0; i < folder.name_count; ++i)
                 {
-                    std::string extension = filesystem::getExtension(info.name);
-                    if (!extension.empty() && mango::image::isImageDecoder(extension))
-                    {
-                        std::string filename = mango::removePrefix(path.pathname() + info.name, prefix);
-                        names.emplace_back(filename);
-                    }
+                    table.append(id, m_cache->name(folder.name_first + i), false);
+                    added();
                 }
-                else
+            }
+            else
+            {
+                const u32 id = table.folder(node->relative);
+
+                for (const std::string& name : node->names)
                 {
-                    const int cost = info.isContainer();
-                    if (depth < 2)
-                    {
-                        subfolders.emplace_back(info.name, cost);
-                    }
+                    table.append(id, name);
+                    added();
                 }
+
+                node->names = std::vector<std::string>();
             }
-        }
+        };
 
-        // sort names
-        std::sort(names.begin(), names.end());
+        // While a cached index is being verified its names stay published; the walk's
+        // own result is only swapped in at the end, and only if it differs.
+        if (m_cache)
+        {
+            append(m_pending, node, [] {});
+            return;
+        }
 
         // store names
-        if (!names.empty())
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_filenames.insert(m_filenames.end(), names.begin(), names.end());
+
+            size_t position = m_names.size();
+            append(m_names, node, [&] { m_positions.insert(position++); });
+        }
+
+        m_published_cv.notify_all();
+    }
+
+    void ImageFileIndexer::rebuildPositions()
+    {
+        // Caller holds m_mutex.
+        m_positions.rebuild();
+    }
+
+    void ImageFileIndexer::finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+
+        m_published_cv.notify_all();
+    }
+
+    void ImageFileIndexer::writeCache()
+    {
+        std::vector<IndexCache::FolderEntry> folders;
+        std::vector<FilenameTable::Entry> names;
+
+        {
+            // Watch mode and expand() edit the tree and the list under m_mutex; copy a
+            // consistent snapshot and write it without holding up lookups.
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Flatten the tree in depth-first order; this matches the order the names
+            // were published in, so each folder owns a contiguous name range.
+            std::vector<Node*> order;
+            std::unordered_map<const Node*, u32> position;
+            std::vector<Node*> stack { m_root.get() };
+
+            while (!stack.empty())
+            {
+                Node* node = stack.back();
+                stack.pop_back();
+
+                position.emplace(node, u32(order.size()));
+                order.push_back(node);
+
+                for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+                {
+                    stack.push_back(it->get());
+                }
+            }
+
+            folders.resize(order.size());
+
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                const Node* node = order[i];
+                IndexCache::FolderEntry& entry = folders[i];
+
+                entry.relative = node->relative;
+                entry.stamp = node->stamp;
+                entry.archive = node->archive;
+                entry.lazy = node->lazy;
+                entry.first = node->first;
+                entry.count = node->count;
+
+                for (const auto& child : node->children)
+                {
+                    entry.children.push_back(position[child.get()]);
+                }
+            }
+
+            // The names themselves stay in the table's arena until the next start().
+            names = m_names.entries();
         }
 
-        for (const auto& [name, cost] : subfolders)
+        if (!IndexCache::write(m_prefix, folders, names))
         {
-            std::lock_guard<std::recursive_mutex> lock(filesystem_mutex);
-            Path child(path, name);
-            folder(child, prefix, depth + cost);
+            printLine(Print::Info, "Indexer: could not write index cache.");
         }
     }
 
@@ -99,6 +503,11 @@ namespace ifap
         return m_running;
     }
 
+    size_t ImageFileIndexer::generation() const
+    {
+        return m_generation;
+    }
+
     void ImageFileIndexer::start(const std::string& pathname)
     {
         reset();
@@ -109,18 +518,108 @@ namespace ifap
         m_queue.enqueue([this, pathname]
         {
             u64 time0 = mango::Time::ms();
-            printLine(Print::Info, "Indexer: start.");
 
+            // Map the previous session's index first so the whole list is available
+            // before the first folder has been stat'ed.
+            m_cache = IndexCache::open(pathname);
+            printLine(Print::Info, "Indexer: start{}.", m_cache ? " (verifying cached index)" : "");
+
+            m_prefix = pathname;
+            m_folder_count = 0;
+            m_cached_count = 0;
+            m_lazy_count = 0;
+            m_opened_containers = 0;
+            m_header_bytes = 0;
+            m_pruned_count = 0;
+            m_published = 0;
+            m_root = std::make_unique<Node>();
+            m_root->container = nativePathLength(pathname) < pathname.size();
+
+            if (m_cache)
             {
-                std::lock_guard<std::recursive_mutex> lock(filesystem_mutex);
-                Path path(pathname);
-                folder(path, pathname, 0);
+                // Publish the mapped names without copying a single string; both tables
+                // keep the mapping alive for as long as they reference it.
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                std::vector<u32> folders(m_cache->folderCount());
+                for (size_t i = 0; i < folders.size(); ++i)
+                {
+                    folders[i] = m_names.folder(m_cache->folder(i).relative, false);
+                }
+
+                for (size_t i = 0; i < m_cache->size(); ++i)
+                {
+                    m_names.append(folders[m_cache->nameFolder(i)], m_cache->name(i), false);
+                }
+
+                m_names.retain(m_cache);
+                m_pending.retain(m_cache);
+                m_positions.rebuild();
             }
 
-            u64 time1 = mango::Time::ms();
-            printLine(Print::Info, "Indexer: complete {} ms.", time1 - time0);
+            m_published_cv.notify_all();
 
-            m_running = false;
+            folder(nullptr, m_root.get());
+
+            if (!m_stop)
+            {
+                bool changed = true;
+
+                if (m_cache)
+                {
+                    changed = !m_pending.equals(m_names);
+
+                    if (changed)
+                    {
+                        // The superseded storage is released by the next start().
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_names.adopt(std::move(m_pending));
+                        m_positions.rebuild();
+                        m_changes.replaced = true;
+                        m_changes.edits.clear();
+                        ++m_generation;
+                    }
+
+                    m_pending.clear();
+                    m_cache.reset();
+                }
+
+                if (changed)
+                {
+                    writeCache();
+                }
+
+                u64 time1 = mango::Time::ms();
+                printLine(Print::Info, "Indexer: complete {} ms ({} files, {} folders, {} from cache{}, {} KB names).",
+                    time1 - time0, size(), m_folder_count.load(), m_cached_count.load(),
+                    changed ? "" : ", unchanged", m_names.memoryUsage() / 1024);
+                printLine(Print::Info, "Indexer: {} containers opened ({} KB headers), {} deferred, {} entries pruned.",
+                    m_opened_containers.load(), m_header_bytes.load() / 1024,
+                    m_lazy_count.load(), m_pruned_count.load());
+
+                const FilesystemLockStats locks = filesystemLockStats();
+                printLine(Print::Info, "Indexer: filesystem locks {} taken, {} contended ({} ms blocked).",
+                    locks.acquired, locks.contended, locks.wait_us / 1000);
+
+                if (index_watch_folders)
+                {
+                    // The walked tree stays alive as the model the watcher edits.
+                    startWatching();
+                }
+
+                if (index_probe_headers)
+                {
+                    startProbe();
+                }
+            }
+
+            // Unopened containers need the tree too: expand() grafts into it.
+            if (!m_watcher.joinable() && (m_stop || !m_lazy_count))
+            {
+                m_root.reset();
+            }
+
+            finish();
         });
     }
 
@@ -129,22 +628,1200 @@ namespace ifap
         m_stop = true;
         m_queue.cancel();
         m_queue.wait();
+
+        // Last: the walk job starts the watcher and the prober, so they are only final
+        // once the queue is idle.
+        stopWatching();
+        stopProbe();
+
+        // A walk cancelled before it started never reached finish(); release waiters.
+        finish();
     }
 
-    size_t ImageFileIndexer::size() const
+    IndexChanges ImageFileIndexer::takeChanges()
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_filenames.size();
+        IndexChanges changes = std::move(m_changes);
+        m_changes = IndexChanges();
+        return changes;
     }
 
-    std::string ImageFileIndexer::operator [] (size_t index) const
+    // -----------------------------------------------------------------------
+    // Watch mode
+    // -----------------------------------------------------------------------
+
+    void ImageFileIndexer::renumber()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (index >= m_filenames.size())
+        // Rebuild the depth-first folder order and every folder's published range.
+        m_order.clear();
+
+        size_t position = 0;
+        std::vector<Node*> stack { m_root.get() };
+
+        while (!stack.empty())
         {
-            return {};
+            Node* node = stack.back();
+            stack.pop_back();
+
+            node->order = m_order.size();
+            node->first = position;
+            position += node->count;
+            m_order.push_back(node);
+
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+            {
+                stack.push_back(it->get());
+            }
+        }
+    }
+
+    void ImageFileIndexer::beginEdits()
+    {
+        // The first edit of a batch notes where every folder sits in the published list;
+        // edits go to per-folder copies and commitEdits() rebuilds the list once.
+        if (!m_editing)
+        {
+            renumber();
+
+            for (Node* node : m_order)
+            {
+                node->listed = node->first;
+            }
+
+            m_listed = m_names.entries();
+            m_editing = true;
+        }
+    }
+
+    std::vector<FilenameTable::Entry>& ImageFileIndexer::folderEntries(Node* folder)
+    {
+        beginEdits();
+
+        auto it = m_edited.find(folder);
+        if (it == m_edited.end())
+        {
+            // First edit of the folder in this batch: start from its published range.
+            auto first = m_listed.begin() + folder->listed;
+            it = m_edited.emplace(folder, std::vector<FilenameTable::Entry>(first, first + folder->count)).first;
+        }
+
+        return it->second;
+    }
+
+    void ImageFileIndexer::commitEdits(size_t first_edit)
+    {
+        if (m_editing)
+        {
+            // One pass in folder order: edited folders from their copies, the rest from
+            // their range of the previous list.
+            std::vector<FilenameTable::Entry> entries;
+            entries.reserve(m_order.empty() ? 0 : m_order.back()->first + m_order.back()->count);
+
+            for (Node* node : m_order)
+            {
+                auto it = m_edited.find(node);
+                if (it != m_edited.end())
+                {
+                    entries.insert(entries.end(), it->second.begin(), it->second.end());
+                }
+                else
+                {
+                    auto first = m_listed.begin() + node->listed;
+                    entries.insert(entries.end(), first, first + node->count);
+                }
+            }
+
+            m_names.publish(std::move(entries));
+            m_listed = std::vector<FilenameTable::Entry>();
+            m_edited.clear();
+            m_editing = false;
+        }
+
+        if (m_changes.edits.size() != first_edit)
+        {
+            rebuildPositions();
+
+            std::lock_guard<std::mutex> metadata_lock(m_metadata_mutex);
+            for (size_t i = first_edit; i < m_changes.edits.size(); ++i)
+            {
+                m_metadata.apply(m_changes.edits[i]);
+            }
+
+            ++m_generation;
+            m_probe_cv.notify_all();
+        }
+    }
+
+    ImageFileIndexer::Node* ImageFileIndexer::findNode(const std::string& relative) const
+    {
+        // Every relative path ends with '/', so a prefix match selects one child per level.
+        Node* node = m_root.get();
+
+        while (node && node->relative != relative)
+        {
+            Node* next = nullptr;
+
+            for (auto& child : node->children)
+            {
+                if (!relative.compare(0, child->relative.size(), child->relative))
+                {
+                    next = child.get();
+                    break;
+                }
+            }
+
+            node = next;
+        }
+
+        return node;
+    }
+
+    ImageFileIndexer::Node* ImageFileIndexer::findChild(Node* node, const std::string& name) const
+    {
+        for (auto& child : node->children)
+        {
+            if (child->name == name)
+            {
+                return child.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    size_t ImageFileIndexer::subtreeCount(const Node* node) const
+    {
+        size_t count = node->count;
+        for (const auto& child : node->children)
+        {
+            count += subtreeCount(child.get());
+        }
+        return count;
+    }
+
+    size_t ImageFileIndexer::addFile(Node* folder, const std::string& name)
+    {
+        if (classifyFilename(name) != EntryClass::Image)
+        {
+            return size_t(-1);
+        }
+
+        std::vector<FilenameTable::Entry>& entries = folderEntries(folder);
+
+        // A folder's entries share its prefix, so ordering by basename is enough.
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::string_view(name),
+            [] (const FilenameTable::Entry& entry, std::string_view value)
+            {
+                return entry.basename() < value;
+            });
+
+        if (it != entries.end() && it->basename() == name)
+        {
+            // Already indexed (e.g. IN_CLOSE_WRITE after rewriting an existing file).
+            return size_t(-1);
+        }
+
+        FilenameTable::Entry entry;
+        entry.folder = m_names.folder(folder->relative);
+        entry.length = u32(name.size());
+        entry.name = m_names.store(name);
+
+        const size_t position = folder->first + size_t(it - entries.begin());
+        entries.insert(it, entry);
+
+        ++folder->count;
+        for (size_t i = folder->order + 1; i < m_order.size(); ++i)
+        {
+            ++m_order[i]->first;
+        }
+
+        m_changes.edits.push_back({ IndexEdit::Type::Insert, position, 0 });
+        return position;
+    }
+
+    size_t ImageFileIndexer::removeFile(Node* folder, const std::string& name, bool record)
+    {
+        std::vector<FilenameTable::Entry>& entries = folderEntries(folder);
+
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::string_view(name),
+            [] (const FilenameTable::Entry& entry, std::string_view value)
+            {
+                return entry.basename() < value;
+            });
+
+        if (it == entries.end() || it->basename() != name)
+        {
+            return size_t(-1);
+        }
+
+        const size_t position = folder->first + size_t(it - entries.begin());
+        entries.erase(it);
+
+        --folder->count;
+        for (size_t i = folder->order + 1; i < m_order.size(); ++i)
+        {
+            --m_order[i]->first;
+        }
+
+        if (record)
+        {
+            m_changes.edits.push_back({ IndexEdit::Type::Erase, position, 0 });
+        }
+
+        return position;
+    }
+
+    void ImageFileIndexer::moveFile(Node* from, const std::string& from_name, Node* to, const std::string& to_name)
+    {
+        const size_t position = removeFile(from, from_name, false);
+        if (position == size_t(-1))
+        {
+            addFile(to, to_name);
+            return;
+        }
+
+        const size_t edits = m_changes.edits.size();
+        const size_t target = addFile(to, to_name);
+
+        if (target == size_t(-1))
+        {
+            // Renamed to something we do not index.
+            m_changes.edits.push_back({ IndexEdit::Type::Erase, position, 0 });
+            return;
+        }
+
+        // Record a single move instead of the erase + insert pair, so the texture cache
+        // keeps the decoded image for the renamed file.
+        m_changes.edits.resize(edits);
+        m_changes.edits.push_back({ IndexEdit::Type::Move, position, target });
+    }
+
+    void ImageFileIndexer::scanTree(Node* node, bool watch)
+    {
+        std::vector<std::pair<std::string, bool>> subfolders;
+
+        if (watch)
+        {
+            // Watched before it is listed, so a file created in between still arrives
+            // as an event (and one already listed is ignored as a duplicate).
+            watchFolder(node);
+        }
+
+        node->stamp = IndexCache::stamp(m_prefix + node->relative);
+
+        try
+        {
+            if (!nativeFolder(node, subfolders))
+            {
+                FilesystemLock lock(m_prefix + node->relative);
+
+                Path path(m_prefix + node->relative);
+                scanFolder(path, node, subfolders);
+            }
+        }
+        catch (...)
+        {
+            node->names.clear();
+            node->stamp = 0;
+            subfolders.clear();
+        }
+
+        std::sort(node->names.begin(), node->names.end());
+        std::sort(subfolders.begin(), subfolders.end());
+
+        node->count = node->names.size();
+
+        for (const auto& [name, archive] : subfolders)
+        {
+            auto child = makeChild(node, name, archive);
+            if (!child)
+            {
+                continue;
+            }
+
+            if (!child->lazy)
+            {
+                child->complete = true;
+                scanTree(child.get(), watch);
+            }
+
+            node->children.emplace_back(std::move(child));
+        }
+    }
+
+    size_t ImageFileIndexer::collectEntries(Node* node)
+    {
+        // Entries of a subtree new to the list, one copy per folder for commitEdits().
+        std::vector<FilenameTable::Entry>& entries = m_edited[node];
+        entries.clear();
+
+        const u32 folder = m_names.folder(node->relative);
+
+        if (node->lazy)
+        {
+            FilenameTable::Entry entry;
+            entry.folder = folder;
+            entry.name = m_names.store(std::string_view());
+            entries.push_back(entry);
+            return 1;
+        }
+
+        for (const std::string& name : node->names)
+        {
+            FilenameTable::Entry entry;
+            entry.folder = folder;
+            entry.length = u32(name.size());
+            entry.name = m_names.store(name);
+            entries.push_back(entry);
+        }
+
+        node->names = std::vector<std::string>();
+
+        size_t count = entries.size();
+
+        for (auto& child : node->children)
+        {
+            count += collectEntries(child.get());
+        }
+
+        return count;
+    }
+
+    void ImageFileIndexer::releaseTree(Node* node)
+    {
+        // A subtree leaving the model: nothing of it may stay watched, counted or edited.
+        std::vector<Node*> stack { node };
+
+        while (!stack.empty())
+        {
+            Node* current = stack.back();
+            stack.pop_back();
+
+            unwatchFolder(current);
+            m_edited.erase(current);
+
+            if (current->lazy)
+            {
+                --m_lazy_count;
+            }
+
+            for (auto& child : current->children)
+            {
+                stack.push_back(child.get());
+            }
+        }
+    }
+
+    void ImageFileIndexer::addFolder(Node* parent, const std::string& name, bool archive, std::unique_ptr<Node> scanned)
+    {
+        if (findChild(parent, name))
+        {
+            if (scanned)
+            {
+                releaseTree(scanned.get());
+            }
+            return;
+        }
+
+        std::unique_ptr<Node> node = std::move(scanned);
+
+        if (!node || node->parent != parent)
+        {
+            if (node)
+            {
+                releaseTree(node.get());
+            }
+
+            // Not scanned ahead (the batch removed and re-added it). Same recursion
+            // policy as the walk: a new container usually arrives as a placeholder.
+            node = makeChild(parent, name, archive);
+            if (!node)
+            {
+                return;
+            }
+
+            if (!node->lazy)
+            {
+                node->complete = true;
+                scanTree(node.get(), true);
+            }
+        }
+
+        beginEdits();
+
+        Node* added = node.get();
+
+        auto it = std::lower_bound(parent->children.begin(), parent->children.end(), name,
+            [] (const std::unique_ptr<Node>& child, const std::string& value)
+            {
+                return child->name < value;
+            });
+        parent->children.insert(it, std::move(node));
+
+        renumber();
+
+        const size_t position = added->first;
+        const size_t count = collectEntries(added);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_changes.edits.push_back({ IndexEdit::Type::Insert, position + i, 0 });
+        }
+
+        std::vector<Node*> stack { added };
+        while (!stack.empty())
+        {
+            Node* current = stack.back();
+            stack.pop_back();
+
+            watchFolder(current);
+
+            for (auto& child : current->children)
+            {
+                stack.push_back(child.get());
+            }
+        }
+    }
+
+    void ImageFileIndexer::removeFolder(Node* node)
+    {
+        Node* parent = node->parent;
+        if (!parent)
+        {
+            return;
+        }
+
+        beginEdits();
+
+        const size_t position = node->first;
+        const size_t count = subtreeCount(node);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_changes.edits.push_back({ IndexEdit::Type::Erase, position, 0 });
+        }
+
+        releaseTree(node);
+
+        auto it = std::find_if(parent->children.begin(), parent->children.end(),
+            [node] (const std::unique_ptr<Node>& child)
+            {
+                return child.get() == node;
+            });
+
+        if (it != parent->children.end())
+        {
+            parent->children.erase(it);
+        }
+
+        renumber();
+    }
+
+    void ImageFileIndexer::expand(const std::string& relative)
+    {
+        auto done = [this, &relative]
+        {
+            std::lock_guard<std::mutex> lock(m_expand_mutex);
+            m_expanding.erase(relative);
+        };
+
+        // The container is listed on a detached node so the index stays usable while
+        // it is opened; only the graft runs under the lock.
+        auto detached = std::make_unique<Node>();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            Node* node = findNode(relative);
+            if (m_stop || !node || !node->lazy)
+            {
+                done();
+                return;
+            }
+
+            detached->relative = node->relative;
+            detached->name = node->name;
+            detached->depth = node->depth;
+            detached->level = node->level;
+            detached->archive = true;
+            detached->container = true;
+            detached->complete = true;
+        }
+
+        const u64 time0 = Time::ms();
+
+        chargeContainer(detached.get());
+        scanTree(detached.get());
+
+        size_t count = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            Node* node = findNode(relative);
+            if (!m_stop && node && node->lazy)
+            {
+                const size_t edits = m_changes.edits.size();
+
+                beginEdits();
+
+                const size_t position = node->first;
+
+                node->lazy = false;
+                node->count = detached->count;
+                node->names = std::move(detached->names);
+                node->children = std::move(detached->children);
+
+                for (auto& child : node->children)
+                {
+                    child->parent = node;
+                }
+
+                --m_lazy_count;
+                renumber();
+
+                count = collectEntries(node);
+
+                // Inserted behind the placeholder before it is erased: a view parked on
+                // the placeholder stays put and lands on the container's first file.
+                for (size_t i = 0; i < count; ++i)
+                {
+                    m_changes.edits.push_back({ IndexEdit::Type::Insert, position + 1 + i, 0 });
+                }
+
+                m_changes.edits.push_back({ IndexEdit::Type::Erase, position, 0 });
+
+                commitEdits(edits);
+            }
+        }
+
+        done();
+
+        printLine(Print::Info, "Indexer: expanded {} ({} files, {} ms).", relative, count, Time::ms() - time0);
+    }
+
+#if defined(__linux__)
+
+    void ImageFileIndexer::watchFolder(Node* node)
+    {
+        // Containers cannot be watched; a changed archive shows up as an event on the
+        // native folder that holds it.
+        if (m_inotify < 0 || node->container || node->watch >= 0)
+        {
+            return;
+        }
+
+        const std::string pathname = m_prefix + node->relative;
+        const u32 mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+        const int watch = inotify_add_watch(m_inotify, pathname.c_str(), mask);
+        if (watch < 0)
+        {
+            printLine(Print::Info, "Indexer: cannot watch {} (errno {}).", pathname, errno);
+            return;
+        }
+
+        node->watch = watch;
+        m_watches[watch] = node;
+    }
+
+    void ImageFileIndexer::unwatchFolder(Node* node)
+    {
+        if (node->watch < 0)
+        {
+            return;
+        }
+
+        // Fails harmlessly when the kernel already dropped the watch with the folder.
+        inotify_rm_watch(m_inotify, node->watch);
+        m_watches.erase(node->watch);
+        node->watch = -1;
+    }
+
+    void ImageFileIndexer::startWatching()
+    {
+        if (m_stop || !m_root || nativePathLength(m_prefix) < m_prefix.size())
+        {
+            return;
+        }
+
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (m_inotify < 0 || m_wakeup < 0)
+        {
+            stopWatching();
+            return;
+        }
+
+        renumber();
+
+        m_cache_dirty = false;
+        m_cache_stale = false;
+
+        for (Node* node : m_order)
+        {
+            watchFolder(node);
+        }
+
+        printLine(Print::Info, "Indexer: watching {} folders.", m_watches.size());
+
+        m_watcher = std::thread([this] { watchThreadMain(); });
+    }
+
+    void ImageFileIndexer::stopWatching()
+    {
+        if (m_watcher.joinable())
+        {
+            const u64 value = 1;
+            ssize_t written = ::write(m_wakeup, &value, sizeof(value));
+            MANGO_UNREFERENCED(written);
+            m_watcher.join();
+        }
+
+        if (m_inotify >= 0)
+        {
+            ::close(m_inotify);
+            m_inotify = -1;
+        }
+
+        if (m_wakeup >= 0)
+        {
+            ::close(m_wakeup);
+            m_wakeup = -1;
+        }
+
+        m_watches.clear();
+    }
+
+    void ImageFileIndexer::watchThreadMain()
+    {
+        alignas(inotify_event) char buffer[64 * 1024];
+
+        for (;;)
+        {
+            pollfd fds[] =
+            {
+                { m_inotify, POLLIN, 0 },
+                { m_wakeup, POLLIN, 0 },
+            };
+
+            // With edits pending, a quiet period (or stopping) writes the index cache.
+            const int timeout = m_cache_dirty ? index_cache_write_delay_ms : -1;
+            const int ready = ::poll(fds, 2, timeout);
+
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+
+            if (!ready || fds[1].revents || m_stop)
+            {
+                if (m_cache_dirty && !m_cache_stale)
+                {
+                    writeCache();
+                }
+
+                m_cache_dirty = false;
+
+                if (ready)
+                {
+                    return;
+                }
+
+                continue;
+            }
+
+            // Drain everything that is queued and apply it as one batch, so a rename
+            // (IN_MOVED_FROM + IN_MOVED_TO with a shared cookie) becomes a single move.
+            std::vector<char> events;
+
+            for (;;)
+            {
+                const ssize_t bytes = ::read(m_inotify, buffer, sizeof(buffer));
+                if (bytes <= 0)
+                {
+                    break;
+                }
+                events.insert(events.end(), buffer, buffer + bytes);
+            }
+
+            // New folders and archives (a copied-in tree) are scanned before the lock is
+            // taken, so lookups do not wait for the disk; only the graft runs under it.
+            // Only this thread edits native folders and m_watches, so reading them here
+            // is safe. One slot per event.
+            std::vector<std::unique_ptr<Node>> scanned;
+
+            for (size_t offset = 0; offset + sizeof(inotify_event) <= events.size() && !m_stop; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                std::unique_ptr<Node>& node = scanned.emplace_back();
+
+                auto it = m_watches.find(event->wd);
+                if (!event->len || it == m_watches.end())
+                {
+                    continue;
+                }
+
+                const std::string name = event->name;
+                const bool directory = (event->mask & IN_ISDIR) != 0;
+                const bool archive = !directory && classifyFilename(name) == EntryClass::Container;
+                const bool added = directory ? (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 :
+                                   archive && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0;
+
+                if (added && !findChild(it->second, name + "/"))
+                {
+                    node = makeChild(it->second, name + "/", archive);
+                    if (node && !node->lazy)
+                    {
+                        node->complete = true;
+                        scanTree(node.get(), true);
+                    }
+                }
+            }
+
+            if (m_stop)
+            {
+                continue;
+            }
+
+            struct MovedFrom
+            {
+                Node* folder;
+                std::string name;
+                bool directory;
+            };
+
+            std::unordered_map<u32, MovedFrom> moved;
+
+            // Folders whose contents changed get a fresh stamp for the index cache.
+            std::unordered_set<std::string> touched;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const size_t edits = m_changes.edits.size();
+            size_t ordinal = 0;
+
+            for (size_t offset = 0; offset + sizeof(inotify_event) <= events.size(); )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                std::unique_ptr<Node>& ahead = scanned[ordinal++];
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    printLine(Print::Info, "Indexer: watch queue overflow; some changes were missed.");
+                    m_cache_stale = true;
+                    continue;
+                }
+
+                auto it = m_watches.find(event->wd);
+                if (it == m_watches.end())
+                {
+                    continue;
+                }
+
+                Node* folder = it->second;
+
+                if (event->mask & IN_IGNORED)
+                {
+                    folder->watch = -1;
+                    m_watches.erase(it);
+                    continue;
+                }
+
+                if (!event->len)
+                {
+                    continue;
+                }
+
+                touched.insert(folder->relative);
+
+                const std::string name = event->name;
+                const bool directory = (event->mask & IN_ISDIR) != 0;
+                const bool archive = !directory && classifyFilename(name) == EntryClass::Container;
+
+                if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    if (event->mask & IN_MOVED_FROM)
+                    {
+                        moved[event->cookie] = MovedFrom { folder, name, directory || archive };
+                        continue;
+                    }
+
+                    if (directory || archive)
+                    {
+                        if (Node* child = findChild(folder, name + "/"))
+                        {
+                            removeFolder(child);
+                        }
+                    }
+                    else
+                    {
+                        removeFile(folder, name);
+                    }
+                }
+                else if (event->mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    if (directory)
+                    {
+                        auto source = moved.find(event->cookie);
+                        if (source != moved.end() && source->second.directory)
+                        {
+                            if (Node* child = findChild(source->second.folder, source->second.name + "/"))
+                            {
+                                removeFolder(child);
+                            }
+                            moved.erase(source);
+                        }
+
+                        addFolder(folder, name + "/", false, std::move(ahead));
+                    }
+                    else if (archive)
+                    {
+                        // Wait for the archive to be complete before opening it.
+                        if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                        {
+                            addFolder(folder, name + "/", true, std::move(ahead));
+                        }
+                    }
+                    else if (event->mask & IN_MOVED_TO)
+                    {
+                        auto source = moved.find(event->cookie);
+                        if (source != moved.end() && !source->second.directory)
+                        {
+                            moveFile(source->second.folder, source->second.name, folder, name);
+                            moved.erase(source);
+                        }
+                        else
+                        {
+                            addFile(folder, name);
+                        }
+                    }
+                    else if (event->mask & IN_CLOSE_WRITE)
+                    {
+                        addFile(folder, name);
+                    }
+                }
+            }
+
+            // Moved out of the watched tree.
+            for (auto& [cookie, source] : moved)
+            {
+                if (source.directory)
+                {
+                    if (Node* child = findChild(source.folder, source.name + "/"))
+                    {
+                        removeFolder(child);
+                    }
+                }
+                else
+                {
+                    removeFile(source.folder, source.name);
+                }
+            }
+
+            // Scanned for an event that did not add it after all.
+            for (auto& node : scanned)
+            {
+                if (node)
+                {
+                    releaseTree(node.get());
+                }
+            }
+
+            for (const std::string& relative : touched)
+            {
+                if (Node* node = findNode(relative))
+                {
+                    node->stamp = IndexCache::stamp(m_prefix + node->relative);
+                }
+            }
+
+            m_cache_dirty = m_cache_dirty || !touched.empty();
+
+            commitEdits(edits);
+        }
+    }
+
+#else
+
+    void ImageFileIndexer::watchFolder(Node* node)
+    {
+        MANGO_UNREFERENCED(node);
+    }
+
+    void ImageFileIndexer::unwatchFolder(Node* node)
+    {
+        MANGO_UNREFERENCED(node);
+    }
+
+    void ImageFileIndexer::startWatching()
+    {
+    }
+
+    void ImageFileIndexer::stopWatching()
+    {
+    }
+
+    void ImageFileIndexer::watchThreadMain()
+    {
+    }
+
+#endif
+
+    // -----------------------------------------------------------------------
+    // Header probe
+    // -----------------------------------------------------------------------
+
+    void ImageFileIndexer::startProbe()
+    {
+        if (m_stop || m_prober.joinable())
+        {
+            return;
+        }
+
+        m_probe_hold = false;
+        m_prober = std::thread([this] { probeThreadMain(); });
+    }
+
+    void ImageFileIndexer::stopProbe()
+    {
+        if (!m_prober.joinable())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_metadata_mutex);
+            m_probe_cv.notify_all();
+        }
+
+        m_prober.join();
+    }
+
+    void ImageFileIndexer::probeThreadMain()
+    {
+#if defined(__linux__)
+        // Only use otherwise idle CPU; the I/O scheduler follows the CPU class.
+        sched_param param {};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+        u64 time0 = mango::Time::ms();
+        size_t probed = 0;
+        size_t next = 0;
+        size_t last_generation = size_t(-1);
+        bool logged = false;
+
+        while (!m_stop)
+        {
+            size_t index = 0;
+            size_t generation = 0;
+            std::string name;
+
+            {
+                std::unique_lock<std::mutex> lock(m_metadata_mutex);
+
+                // Woken by holdProbe(false) and stopProbe().
+                m_probe_cv.wait(lock, [this]
+                {
+                    return !m_probe_hold || m_stop;
+                });
+
+                if (m_stop)
+                {
+                    break;
+                }
+
+                generation = m_generation;
+                if (generation != last_generation)
+                {
+                    // Positions moved; look for unprobed rows from the start again.
+                    last_generation = generation;
+                    next = 0;
+                }
+
+                const size_t count = m_names.size();
+                while (next < count && m_metadata.known(next))
+                {
+                    ++next;
+                }
+
+                if (next >= count)
+                {
+                    if (!logged)
+                    {
+                        logged = true;
+                        printLine(Print::Info, "Indexer: probed {} headers in {} ms.",
+                            probed, mango::Time::ms() - time0);
+                    }
+
+                    // Everything is known. Watch-mode edits and container expansion
+                    // (commitEdits()), holdProbe() and stopProbe() wake it again.
+                    m_probe_cv.wait(lock, [this, generation]
+                    {
+                        return m_generation != generation || m_stop;
+                    });
+                    continue;
+                }
+
+                index = next;
+                name = m_names[index].str();
+            }
+
+            // Files inside containers would have to be extracted; leave them unknown.
+            const std::string pathname = m_prefix + name;
+            ImageMetadata metadata;
+            const bool valid = nativePathLength(pathname) == pathname.size() &&
+                               probeImageHeader(pathname, metadata);
+
+            std::lock_guard<std::mutex> lock(m_metadata_mutex);
+
+            if (m_generation != generation)
+            {
+                continue;
+            }
+
+            if (valid)
+            {
+                m_metadata.set(index, metadata);
+                ++probed;
+            }
+            else
+            {
+                m_metadata.fail(index);
+            }
+
+            ++next;
+        }
+    }
+
+    bool ImageFileIndexer::metadata(size_t index, ImageMetadata& metadata) const
+    {
+        std::lock_guard<std::mutex> lock(m_metadata_mutex);
+        return m_metadata.get(index, metadata);
+    }
+
+    void ImageFileIndexer::holdProbe(bool hold)
+    {
+        if (hold)
+        {
+            m_probe_hold = true;
+            return;
+        }
+
+        // Called every frame; only a release wakes the prober.
+        if (m_probe_hold.exchange(false))
+        {
+            std::lock_guard<std::mutex> lock(m_metadata_mutex);
+            m_probe_cv.notify_all();
+        }
+    }
+
+    bool ImageFileIndexer::isPlaceholder(size_t index) const
+    {
+        if (index >= size())
+        {
+            return false;
+        }
+
+        const FilenameTable::View view = m_names[index];
+        return view.name.empty() && !view.folder.empty();
+    }
+
+    void ImageFileIndexer::expandNear(size_t index, size_t radius)
+    {
+        if (!m_lazy_count)
+        {
+            return;
+        }
+
+        const size_t count = size();
+        const size_t first = index > radius ? index - radius : 0;
+        const size_t last = std::min(count, index + radius + 1);
+
+        for (size_t i = first; i < last; ++i)
+        {
+            const FilenameTable::View view = m_names[i];
+            if (!view.name.empty() || view.folder.empty())
+            {
+                continue;
+            }
+
+            std::string relative(view.folder);
+
+            std::lock_guard<std::mutex> lock(m_expand_mutex);
+            if (m_expanding.insert(relative).second)
+            {
+                m_queue.enqueue([this, relative]
+                {
+                    expand(relative);
+                });
+            }
+        }
+    }
+
+    size_t ImageFileIndexer::size() const
+    {
+        return m_names.size();
+    }
+
+    FilenameTable::View ImageFileIndexer::operator [] (size_t index) const
+    {
+        return m_names[index];
+    }
+
+    size_t ImageFileIndexer::find(std::string_view name) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_positions.find(name);
+    }
+
+    size_t ImageFileIndexer::waitFor(const std::string& name, const std::function<bool()>& abort) const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;)
+        {
+            if (abort && abort())
+            {
+                return size_t(-1);
+            }
+
+            if (name.empty())
+            {
+                if (m_names.size())
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                const size_t position = m_positions.find(name);
+                if (position != size_t(-1))
+                {
+                    return position;
+                }
+            }
+
+            // finish() flips m_running under m_mutex, so the final publish has already
+            // been observed by the lookup above.
+            if (!m_running)
+            {
+                return size_t(-1);
+            }
+
+            // Woken by publish(); the timeout only bounds how long an abort can go unnoticed.
+            m_published_cv.wait_for(lock, std::chrono::milliseconds(50));
         }
-        return m_filenames[index];
     }
 
 } // namespace ifap
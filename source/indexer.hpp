@@ -7,23 +7,186 @@
 #include <mango/core/thread.hpp>
 #include <mango/filesystem/path.hpp>
 
+#include "filename_table.hpp"
+#include "image_metadata.hpp"
+#include "index_cache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 namespace ifap
 {
 
+    // Length of the leading part of `pathname` that lives on the native filesystem:
+    // up to and including the first container component (without its trailing '/'),
+    // or the whole string when no component names a container.
+    size_t nativePathLength(const std::string& pathname);
+
+    // One incremental change to the published list, in the order it was applied.
+    struct IndexEdit
+    {
+        enum class Type
+        {
+            Insert, // a name was inserted at `position`
+            Erase,  // the name at `position` was removed
+            Move,   // the name at `position` was renamed; it now lives at `target`
+        };
+
+        Type type = Type::Insert;
+        size_t position = 0;
+        size_t target = 0;
+    };
+
+    // Position of `index` after `edit` was applied; -1 when that entry was erased.
+    size_t remapIndex(const IndexEdit& edit, size_t index);
+
+    struct IndexChanges
+    {
+        bool replaced = false;        // the whole list was swapped; positions are unrelated
+        std::vector<IndexEdit> edits; // otherwise, the edits since the last takeChanges()
+    };
+
     class ImageFileIndexer
     {
     protected:
         using Path = mango::filesystem::Path;
 
+        // One folder (or container) of the walk. Names are published depth-first: a
+        // node's sorted names first, then each of its subfolders (sorted by name) in turn.
+        struct Node
+        {
+            std::string relative;   // folder path relative to the indexed root
+            std::string name;       // entry name inside the parent ("" for the root)
+            int depth = 0;          // container nesting level
+            int level = 0;          // plain folder levels below the root
+            bool archive = false;   // the entry itself is a container (costs a depth level)
+            bool container = false; // the folder is, or lives inside, a container
+            bool lazy = false;      // unopened container, published as one placeholder entry
+            s64 stamp = 0;
+            Node* parent = nullptr;
+            int watch = -1;         // inotify watch descriptor (watch mode only)
+            size_t order = 0;       // position in m_order (watch mode only)
+            size_t listed = 0;      // `first` in the list an edit batch started from
+
+            std::vector<std::string> names;       // basenames, until published
+            size_t cached = size_t(-1);           // IndexCache folder that supplies the names
+            std::vector<std::unique_ptr<Node>> children;
+            size_t first = 0;       // published position of the first name
+            size_t count = 0;
+            std::atomic<bool> complete { false };
+        };
+
         mango::SerialQueue m_queue;
         std::atomic<bool> m_running { false };
         std::atomic<bool> m_stop { false };
+        std::atomic<size_t> m_generation { 0 };
         mutable std::mutex m_mutex;
 
-        std::vector<std::string> m_filenames;
+        // Published names; size() and operator[] read it without taking m_mutex. All
+        // writes happen under m_mutex, which also serializes them as the table requires.
+        FilenameTable m_names;
+
+        // Name -> published position, kept in step with m_names under m_mutex.
+        // m_published_cv is signalled whenever names are published or the walk ends.
+        FilenameIndex m_positions { m_names };
+        mutable std::condition_variable m_published_cv;
+
+        // Mapped index from a previous session. Its names are published straight from
+        // the mapping and the walk only verifies them, publishing into m_pending; the
+        // walk's result replaces them only if the tree actually changed.
+        std::shared_ptr<IndexCache> m_cache;
+        FilenameTable m_pending;
+
+        // Walk state, owned by the job running on m_queue.
+        std::string m_prefix;
+        std::unique_ptr<Node> m_root;
+        size_t m_published = 0;
+        std::atomic<size_t> m_folder_count { 0 };
+        std::atomic<size_t> m_cached_count { 0 };
+
+        // Recursion policy bookkeeping (see index_max_* in context.hpp). Lazy containers
+        // keep the tree alive after the walk; expandNear() opens them on m_queue.
+        std::atomic<size_t> m_lazy_count { 0 };
+        std::atomic<size_t> m_opened_containers { 0 };
+        std::atomic<u64> m_header_bytes { 0 };
+        std::atomic<size_t> m_pruned_count { 0 };
+        std::mutex m_expand_mutex;
+        std::unordered_set<std::string> m_expanding;
+
+        // Watch mode: after a completed walk the tree is kept and native folders are
+        // watched with inotify; adds, removes and renames are applied to copies of the
+        // edited folders' entries, the list is rebuilt and published once per batch and
+        // the edits recorded in m_changes for TextureCache::syncIndexer(). The edited
+        // tree goes back to the index cache.
+        IndexChanges m_changes;
+        std::vector<FilenameTable::Entry> m_listed; // published entries when the batch began
+        std::unordered_map<Node*, std::vector<FilenameTable::Entry>> m_edited;
+        bool m_editing = false;
+        std::vector<Node*> m_order;
+        std::unordered_map<int, Node*> m_watches;
+        std::thread m_watcher;
+        int m_inotify = -1;
+        int m_wakeup = -1;
+        bool m_cache_dirty = false; // edits not written to the index cache yet
+        bool m_cache_stale = false; // events were lost; the tree is not worth caching
+
+        // Header probe: after the walk, a low-priority thread fills m_metadata in list
+        // order. Rows are addressed by position, so watch-mode edits are applied to the
+        // table (and m_generation bumped) under m_metadata_mutex; the prober drops a
+        // result whose generation changed while it was reading.
+        ImageMetadataTable m_metadata;
+        mutable std::mutex m_metadata_mutex;
+        std::condition_variable m_probe_cv;
+        std::thread m_prober;
+        std::atomic<bool> m_probe_hold { false };
 
         void reset();
-        void folder(const Path& path, const std::string& prefix, int depth);
+        void folder(const std::shared_ptr<Path>& parent, Node* node);
+        bool cachedFolder(Node* node, std::vector<std::pair<std::string, bool>>& subfolders);
+        bool nativeFolder(Node* node, std::vector<std::pair<std::string, bool>>& subfolders);
+        void scanFolder(const Path& path, Node* node, std::vector<std::pair<std::string, bool>>& subfolders);
+        std::unique_ptr<Node> makeChild(Node* parent, const std::string& name, bool archive);
+        u64 containerBytes(const Node* node) const;
+        bool reserveContainer(const Node* node);
+        void chargeContainer(const Node* node);
+        Node* findNode(const std::string& relative) const;
+        void expand(const std::string& relative);
+        void commitEdits(size_t first_edit);
+        void publish(Node* node);
+        void writeCache();
+        void finish();
+        void rebuildPositions();
+
+        void startWatching();
+        void stopWatching();
+        void watchThreadMain();
+        void startProbe();
+        void stopProbe();
+        void probeThreadMain();
+        void watchFolder(Node* node);
+        void unwatchFolder(Node* node);
+        void renumber();
+        void beginEdits();
+        std::vector<FilenameTable::Entry>& folderEntries(Node* folder);
+        Node* findChild(Node* node, const std::string& name) const;
+        size_t subtreeCount(const Node* node) const;
+        size_t addFile(Node* folder, const std::string& name);
+        size_t removeFile(Node* folder, const std::string& name, bool record = true);
+        void moveFile(Node* from, const std::string& from_name, Node* to, const std::string& to_name);
+        void addFolder(Node* parent, const std::string& name, bool archive, std::unique_ptr<Node> scanned);
+        void removeFolder(Node* node);
+        void scanTree(Node* node, bool watch = false);
+        size_t collectEntries(Node* node);
+        void releaseTree(Node* node);
 
     public:
         ImageFileIndexer();
@@ -31,11 +194,40 @@ namespace ifap
 
         bool isRunning() const;
 
+        // Incremented whenever published positions change: the list was replaced (a
+        // cached index turned out to be stale) or watch mode edited it in place.
+        size_t generation() const;
+
+        // Changes since the previous call (single consumer: the texture cache).
+        IndexChanges takeChanges();
+
         void start(const std::string& pathname);
         void stop();
 
+        // Lock-free. A View stays valid until the next start().
         size_t size() const;
-        std::string operator [] (size_t index) const;
+        FilenameTable::View operator [] (size_t index) const;
+
+        // Position of `name`, or -1 when it has not been indexed (yet). O(1).
+        size_t find(std::string_view name) const;
+
+        // Containers are published as a placeholder (an entry with an empty basename
+        // naming the container folder) until expandNear() opens them; the expansion
+        // arrives as IndexEdits like a watch-mode change.
+        bool isPlaceholder(size_t index) const;
+        void expandNear(size_t index, size_t radius);
+
+        // Header facts from the background probe; false while unknown (not probed yet,
+        // inside a container, or unreadable).
+        bool metadata(size_t index, ImageMetadata& metadata) const;
+
+        // Pauses the probe while set, so it never competes with a visible image's read.
+        void holdProbe(bool hold);
+
+        // Blocks until `name` has been published and returns its position; an empty name
+        // waits for the first file. Returns -1 once the walk has finished without it or
+        // when `abort` returns true (checked on every wakeup and at least every 50 ms).
+        size_t waitFor(const std::string& name, const std::function<bool()>& abort = {}) const;
     };
 
 } // namespace ifap
@@ -0,0 +1,219 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "indexer.hpp"
+#include "readahead.hpp"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ifap
+{
+    using namespace mango;
+
+    namespace
+    {
+
+        // Recently hinted files and opened ZIP directories kept by the lane.
+        constexpr size_t recent_limit = 256;
+        constexpr size_t zip_directory_limit = 16;
+
+    } // namespace
+
+    ReadaheadLane::ReadaheadLane()
+    {
+#if defined(__linux__)
+        m_thread = std::thread([this]
+        {
+            threadMain();
+        });
+#endif
+    }
+
+    ReadaheadLane::~ReadaheadLane()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+
+        m_cv.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void ReadaheadLane::request(std::vector<std::string> pathnames, u64 budget)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_request = std::move(pathnames);
+            m_budget = budget;
+            m_pending = true;
+        }
+
+        m_cv.notify_one();
+    }
+
+    void ReadaheadLane::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request.clear();
+        m_pending = false;
+    }
+
+    void ReadaheadLane::threadMain()
+    {
+        for (;;)
+        {
+            std::vector<std::string> request;
+            u64 budget = 0;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]
+                {
+                    return !m_running || m_pending;
+                });
+
+                if (!m_running)
+                {
+                    return;
+                }
+
+                request = std::move(m_request);
+                budget = m_budget;
+                m_request.clear();
+                m_pending = false;
+            }
+
+            for (const std::string& pathname : request)
+            {
+                if (!budget)
+                {
+                    break;
+                }
+
+                {
+                    // Superseded: start over on the new request.
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_pending || !m_running)
+                    {
+                        break;
+                    }
+                }
+
+                if (std::find(m_recent.begin(), m_recent.end(), pathname) != m_recent.end())
+                {
+                    continue;
+                }
+
+                const u64 bytes = advise(pathname, budget);
+                budget -= std::min(budget, bytes);
+                m_hinted_bytes += bytes;
+
+                m_recent.push_back(pathname);
+                if (m_recent.size() > recent_limit)
+                {
+                    m_recent.pop_front();
+                }
+            }
+        }
+    }
+
+    const std::unordered_map<std::string, ZipMember>* ReadaheadLane::zipDirectory(const std::string& container)
+    {
+        auto it = m_zip_directories.find(container);
+        if (it == m_zip_directories.end())
+        {
+            if (m_zip_directories.size() >= zip_directory_limit)
+            {
+                m_zip_directories.clear();
+            }
+
+            // A container that is not a readable ZIP is remembered as empty.
+            std::unordered_map<std::string, ZipMember> members;
+            readZipDirectory(container, members);
+            it = m_zip_directories.emplace(container, std::move(members)).first;
+        }
+
+        return it->second.empty() ? nullptr : &it->second;
+    }
+
+    u64 ReadaheadLane::advise(const std::string& pathname, u64 budget)
+    {
+#if defined(__linux__)
+        u64 offset = 0;
+        u64 size = 0;
+
+        std::string filename = pathname;
+        const size_t native = nativePathLength(pathname);
+
+        if (native < pathname.size())
+        {
+            const std::string member = pathname.substr(native + 1);
+            if (nativePathLength(member) < member.size())
+            {
+                // Nested container: its bytes are compressed inside the outer one.
+                return 0;
+            }
+
+            filename = pathname.substr(0, native);
+
+            const auto* members = zipDirectory(filename);
+            if (!members)
+            {
+                return 0;
+            }
+
+            auto it = members->find(member);
+            if (it == members->end())
+            {
+                return 0;
+            }
+
+            offset = it->second.offset;
+            size = it->second.size;
+        }
+
+        const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return 0;
+        }
+
+        if (native == pathname.size())
+        {
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+            {
+                ::close(fd);
+                return 0;
+            }
+
+            size = u64(info.st_size);
+        }
+
+        // A file larger than what is left gets its head; the decoder reads front to back.
+        size = std::min(size, budget);
+
+        ::posix_fadvise(fd, off_t(offset), off_t(size), POSIX_FADV_WILLNEED);
+        ::close(fd);
+
+        return size;
+#else
+        MANGO_UNREFERENCED(pathname);
+        MANGO_UNREFERENCED(budget);
+        return 0;
+#endif
+    }
+
+} // namespace ifap
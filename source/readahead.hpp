@@ -0,0 +1,68 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include "directory_scanner.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u64;
+
+    // Warms the page cache for files further ahead than the prefetch window. A request
+    // is the upcoming files in navigation order; the lane walks it on its own thread
+    // and asks the kernel to read ahead (posix_fadvise WILLNEED) until the byte budget
+    // is spent. Native files are hinted whole; members of a native ZIP only over their
+    // own byte range. Anything else (nested or non-ZIP containers) is skipped. A new
+    // request replaces the unfinished part of the previous one. Linux only; elsewhere
+    // requests are ignored.
+    class ReadaheadLane
+    {
+    protected:
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_running = true;
+        std::vector<std::string> m_request;
+        u64 m_budget = 0;
+        bool m_pending = false;
+
+        // Lane thread only.
+        std::unordered_map<std::string, std::unordered_map<std::string, ZipMember>> m_zip_directories;
+        std::deque<std::string> m_recent; // hinted lately; not hinted again
+        std::atomic<u64> m_hinted_bytes { 0 };
+
+        void threadMain();
+        u64 advise(const std::string& pathname, u64 budget);
+        const std::unordered_map<std::string, ZipMember>* zipDirectory(const std::string& container);
+
+    public:
+        ReadaheadLane();
+        ~ReadaheadLane();
+
+        ReadaheadLane(const ReadaheadLane&) = delete;
+        ReadaheadLane& operator = (const ReadaheadLane&) = delete;
+
+        void request(std::vector<std::string> pathnames, u64 budget);
+        void clear();
+
+        // Bytes hinted since startup (diagnostics).
+        u64 hintedBytes() const
+        {
+            return m_hinted_bytes;
+        }
+    };
+
+} // namespace ifap
@@ -57,7 +57,7 @@ namespace ifap::shaders
         inline constexpr const char* g_vertex_main = R"(
             void main()
             {
-                texcoord = inPosition * vec2(0.5, 0.5) + vec2(0.5);
+                texcoord = (inPosition * vec2(0.5, 0.5) + vec2(0.5)) * uTexRegion.zw + uTexRegion.xy;
                 gl_Position = vec4((inPosition + uTransform.xy) * uTransform.zw, 0.0, 1.0);
             }
         )";
@@ -81,6 +81,7 @@ namespace ifap::shaders
             {
                 layout(offset = 0) vec4 uTransform;
                 layout(offset = 16) vec2 uTexScale;
+                layout(offset = 32) vec4 uTexRegion;
             } pc;
         )";
 
@@ -93,6 +94,7 @@ namespace ifap::shaders
             layout(location = 0) out vec2 texcoord;
         )") + detail::g_processing_push_constants + R"(
             #define uTransform pc.uTransform
+            #define uTexRegion pc.uTexRegion
         )" + detail::g_vertex_main;
     }
 
@@ -59,6 +59,16 @@ namespace ifap
         TextureFilter filter = TextureFilter::BILINEAR;
     };
 
+    // One quad of ImageDrawRequest geometry (translate / scale as there) sampling the
+    // normalized sub-rect [texture_offset, texture_offset + texture_scale].
+    struct ImageRegionDraw
+    {
+        float32x2 translate = float32x2(0.0f, 0.0f);
+        float32x2 scale = float32x2(1.0f, 1.0f);
+        float32x2 texture_offset = float32x2(0.0f, 0.0f);
+        float32x2 texture_scale = float32x2(1.0f, 1.0f);
+    };
+
     struct TextureRegionUpload
     {
         int x = 0;
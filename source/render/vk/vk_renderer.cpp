@@ -26,10 +26,13 @@ namespace ifap
         {
             float transform[4];
             float texScale[2];
+            float padding[2];
+            float texRegion[4];
         };
 
         static_assert(offsetof(ProcessingPushConstants, texScale) == 16);
-        static_assert(sizeof(ProcessingPushConstants) == 24);
+        static_assert(offsetof(ProcessingPushConstants, texRegion) == 32);
+        static_assert(sizeof(ProcessingPushConstants) == 48);
 
         constexpr VkFormat kProcessingFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 
@@ -314,7 +317,7 @@ namespace ifap
         void clearTexture(GpuTexture& texture);
         VkSampler selectSampler(TextureFilter filter) const;
         VkPipeline selectPipeline(const ImageDrawRequest& request) const;
-        void recordDraw(const ImageDrawRequest& request);
+        void recordDraw(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count);
         bool isTextureUploadComplete(TextureHandle handle) const;
         bool isTextureLayoutReady(TextureHandle handle) const;
 
@@ -325,6 +328,7 @@ namespace ifap
         void resize(int width, int height);
         bool beginFrame(float clear_r, float clear_g, float clear_b, float clear_a, bool blend);
         void drawImage(const ImageDrawRequest& request);
+        void drawImageRegions(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count);
         void endFrame();
         TextureHandle createTexture(int width, int height, PixelFormat format, const void* initial_data);
         void uploadTextureRegion(TextureHandle handle, PixelFormat format,
@@ -1641,10 +1645,10 @@ namespace ifap
         m_renderTarget->resolve(commandBuffer, swapchain(), imageIndex, &m_outputOptions);
     }
 
-    void VKRenderer::Impl::recordDraw(const ImageDrawRequest& request)
+    void VKRenderer::Impl::recordDraw(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count)
     {
         GpuTexture* texture = getTexture(request.texture);
-        if (!texture || !m_frame_active)
+        if (!texture || !m_frame_active || !regions || count == 0)
         {
             return;
         }
@@ -1714,30 +1718,53 @@ namespace ifap
         // won't free the texture until that frame has retired.
         texture->last_used_value = std::max(texture->last_used_value, m_frame_value);
 
-        ProcessingPushConstants push {};
-        push.transform[0] = request.translate.x;
-        push.transform[1] = request.translate.y;
-        push.transform[2] = request.scale.x;
-        push.transform[3] = request.scale.y;
-        push.texScale[0] = 1.0f / float(std::max(1, request.width));
-        push.texScale[1] = 1.0f / float(std::max(1, request.height));
-
         VkCommandBuffer commandBuffer = frameCommandBuffer(imageIndex);
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, selectPipeline(request));
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_processingPipelineLayout,
             0, 1, &descriptor, 0, nullptr);
-        vkCmdPushConstants(commandBuffer, m_processingPipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ProcessingPushConstants), &push);
 
         VkDeviceSize offset = 0;
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_vertexBuffer.buffer, &offset);
-        vkCmdDraw(commandBuffer, 4, 1, 0, 0);
+
+        // One descriptor for every region: they all sample the same texture, only the
+        // quad placement and the sampled sub-rect change.
+        for (size_t i = 0; i < count; ++i)
+        {
+            const ImageRegionDraw& region = regions[i];
+
+            ProcessingPushConstants push {};
+            push.transform[0] = region.translate.x;
+            push.transform[1] = region.translate.y;
+            push.transform[2] = region.scale.x;
+            push.transform[3] = region.scale.y;
+            push.texScale[0] = 1.0f / float(std::max(1, request.width));
+            push.texScale[1] = 1.0f / float(std::max(1, request.height));
+            push.texRegion[0] = region.texture_offset.x;
+            push.texRegion[1] = region.texture_offset.y;
+            push.texRegion[2] = region.texture_scale.x;
+            push.texRegion[3] = region.texture_scale.y;
+
+            vkCmdPushConstants(commandBuffer, m_processingPipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ProcessingPushConstants), &push);
+            vkCmdDraw(commandBuffer, 4, 1, 0, 0);
+        }
     }
 
     void VKRenderer::Impl::drawImage(const ImageDrawRequest& request)
     {
-        recordDraw(request);
+        const ImageRegionDraw region =
+        {
+            .translate = request.translate,
+            .scale = request.scale,
+        };
+
+        recordDraw(request, &region, 1);
+    }
+
+    void VKRenderer::Impl::drawImageRegions(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count)
+    {
+        recordDraw(request, regions, count);
     }
 
     void VKRenderer::Impl::endFrame()
@@ -1802,6 +1829,7 @@ namespace ifap
     void VKRenderer::resize(int width, int height) { m_impl->resize(width, height); }
     bool VKRenderer::beginFrame(float clear_r, float clear_g, float clear_b, float clear_a, bool blend) { return m_impl->beginFrame(clear_r, clear_g, clear_b, clear_a, blend); }
     void VKRenderer::drawImage(const ImageDrawRequest& request) { m_impl->drawImage(request); }
+    void VKRenderer::drawImageRegions(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count) { m_impl->drawImageRegions(request, regions, count); }
     void VKRenderer::endFrame() { m_impl->endFrame(); }
     int VKRenderer::getMaxTextureDimension() const { return m_impl->getMaxTextureDimension(); }
     TextureHandle VKRenderer::createTexture(int width, int height, PixelFormat format, const void* initial_data) { return m_impl->createTexture(width, height, format, initial_data); }
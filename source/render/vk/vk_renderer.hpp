@@ -32,6 +32,11 @@ namespace ifap
 
         bool beginFrame(float clear_r, float clear_g, float clear_b, float clear_a, bool blend);
         void drawImage(const ImageDrawRequest& request);
+
+        // Draws quads that each sample a sub-rect of one texture (a tile atlas), bound
+        // once. request.translate / scale are unused; width / height are the texture's.
+        void drawImageRegions(const ImageDrawRequest& request, const ImageRegionDraw* regions, size_t count);
+
         void endFrame();
 
         int getMaxTextureDimension() const;
@@ -0,0 +1,184 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "context.hpp"
+#include "filesystem_lock.hpp"
+#include "solid_extractor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace ifap
+{
+    using namespace mango;
+    using namespace mango::filesystem;
+
+    SolidArchiveExtractor::SolidArchiveExtractor(FileCache& file_cache)
+        : m_file_cache(file_cache)
+    {
+        m_thread = std::thread([this]
+        {
+            threadMain();
+        });
+    }
+
+    SolidArchiveExtractor::~SolidArchiveExtractor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    void SolidArchiveExtractor::request(std::shared_ptr<Path> path, std::vector<Member> members,
+                                        s64 stamp, u64 budget)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_path = std::move(path);
+            m_members = std::move(members);
+            m_stamp = stamp;
+            m_budget = budget;
+            m_pending = true;
+        }
+
+        m_cv.notify_one();
+    }
+
+    void SolidArchiveExtractor::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path.reset();
+        m_members.clear();
+        m_pending = true;
+    }
+
+    bool SolidArchiveExtractor::superseded()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending || !m_running;
+    }
+
+    void SolidArchiveExtractor::threadMain()
+    {
+        for (;;)
+        {
+            std::shared_ptr<Path> path;
+            std::vector<Member> members;
+            s64 stamp = 0;
+            u64 budget = 0;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]
+                {
+                    return !m_running || m_pending;
+                });
+
+                if (!m_running)
+                {
+                    return;
+                }
+
+                path = std::move(m_path);
+                members = std::move(m_members);
+                stamp = m_stamp;
+                budget = m_budget;
+                m_members.clear();
+                m_pending = false;
+            }
+
+            if (!path || path->pathname() == m_restarting)
+            {
+                continue;
+            }
+
+            const std::string& prefix = path->pathname();
+            u64 extracted = 0;
+            size_t opened = 0;
+            double best = 0.0; // lowest open time per byte so far, in us
+
+            for (const Member& member : members)
+            {
+                if (extracted >= budget || superseded())
+                {
+                    break;
+                }
+
+                const std::string pathname = prefix + member.name;
+
+                // Already there (read by the prepare worker, or an earlier request):
+                // put it back untouched.
+                FileCache::Entry cached = m_file_cache.take(member.index, pathname, stamp);
+                if (cached.complete())
+                {
+                    extracted += cached.bytes;
+                    m_file_cache.put(member.index, std::move(cached));
+                    continue;
+                }
+
+                try
+                {
+                    std::unique_ptr<File> file;
+                    std::optional<FilesystemLock> lock;
+                    const u64 time0 = Time::us();
+
+                    // Same shard as the prepare worker reading from this archive. The
+                    // member is in memory once opened; the copy runs unlocked, except
+                    // where native mappings are locked too (Windows).
+                    lock.emplace(pathname);
+                    file = std::make_unique<File>(*path, member.name);
+
+                    if (!FilesystemLock::locksNativePaths())
+                    {
+                        lock.reset();
+                    }
+
+                    const u64 elapsed = Time::us() - time0;
+                    const ConstMemory memory = *file;
+
+                    auto buffer = std::make_unique<PooledBuffer>(memory.size);
+                    std::memcpy(buffer->data(), memory.address, memory.size);
+
+                    // Still held only there: unmap before releasing it.
+                    if (lock)
+                    {
+                        file.reset();
+                        lock.reset();
+                    }
+
+                    extracted += memory.size;
+                    m_file_cache.put(member.index, { pathname, stamp, std::move(buffer), memory.size });
+
+                    // The walk pays off only if the mapper carries on from the previous
+                    // member. One that restarts the stream on every open costs the whole
+                    // prefix each time, so the time per byte keeps climbing; stop walking
+                    // that archive. The first open is not counted, it may have to seek.
+                    if (memory.size && ++opened > 1)
+                    {
+                        const double cost = double(elapsed) / double(memory.size);
+                        best = opened == 2 ? cost : std::min(best, cost);
+
+                        if (cost > best * texture_solid_restart_ratio)
+                        {
+                            printLine(Print::Info, "SolidArchiveExtractor: {} restarts the solid stream per member, not extracting ahead.",
+                                prefix);
+                            m_restarting = prefix;
+                            break;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    // Unreadable member: the prepare worker reports it when it gets there.
+                }
+            }
+        }
+    }
+
+} // namespace ifap
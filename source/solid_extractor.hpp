@@ -0,0 +1,75 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+
+#include "file_cache.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ifap
+{
+    using mango::s64;
+    using mango::u64;
+
+    // Background extraction of solid archives (solid RAR: one compressed stream for all
+    // members). Reaching member n costs decompressing members 0..n, so paging through
+    // one member per prepare is quadratic. The extractor instead walks the members
+    // ahead of the view in order, once, and parks their bytes in the FileCache for the
+    // prepare worker to pick up. That only helps while the mapper continues the stream
+    // from the member it opened last: mango has no sequential extract, so the walk is
+    // linear only if its RAR mapper keeps the decompressor state between opens. An
+    // archive where each open is seen restarting the stream is not walked again. A new request replaces the unfinished part of the
+    // previous one; a request stops at its byte budget.
+    class SolidArchiveExtractor
+    {
+    public:
+        struct Member
+        {
+            size_t index;     // index position, the FileCache key
+            std::string name; // relative to the request's Path
+        };
+
+    protected:
+        FileCache& m_file_cache;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_running = true;
+        bool m_pending = false;
+
+        std::shared_ptr<mango::filesystem::Path> m_path;
+        std::vector<Member> m_members;
+        s64 m_stamp = 0;
+        u64 m_budget = 0;
+
+        // Archive whose mapper was seen restarting the solid stream (extractor thread).
+        std::string m_restarting;
+
+        void threadMain();
+        bool superseded();
+
+    public:
+        explicit SolidArchiveExtractor(FileCache& file_cache);
+        ~SolidArchiveExtractor();
+
+        SolidArchiveExtractor(const SolidArchiveExtractor&) = delete;
+        SolidArchiveExtractor& operator = (const SolidArchiveExtractor&) = delete;
+
+        // `members` in archive order; `stamp` is the container's modification stamp.
+        void request(std::shared_ptr<mango::filesystem::Path> path, std::vector<Member> members,
+                     s64 stamp, u64 budget);
+        void clear();
+    };
+
+} // namespace ifap
@@ -2,21 +2,19 @@
     iFap Image Viewer Example for MANGO
     Copyright 2013-2025 Twilight 3D Finland Oy. All rights reserved.
 */
+#include "filesystem_lock.hpp"
 #include "texture.hpp"
 
-#include <mango/image/bicubic.hpp>
-
 #include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <optional>
 
 namespace ifap
 {
 
-    std::recursive_mutex filesystem_mutex;
-
     // Flip to false to silence the decode lifecycle trace.
     static constexpr bool trace_decode = false;
 
@@ -273,6 +271,57 @@ namespace ifap
             task.header_applied = true;
         }
 
+        // Mapping to decode from directly, or nullptr when the file should be copied:
+        // small files, archive entries and anything not on a local mount.
+        std::unique_ptr<File> mapLocalFile(const std::string& pathname)
+        {
+            if (!texture_mapped_reads || nativePathLength(pathname) != pathname.size() ||
+                !isLocalFilesystem(pathname))
+            {
+                return {};
+            }
+
+            auto file = std::make_unique<File>(pathname);
+            const ConstMemory memory = *file;
+
+            if (memory.size < texture_mapped_read_min_size)
+            {
+                return {};
+            }
+
+            adviseSequential(memory.address, memory.size);
+            return file;
+        }
+
+        // Touches one byte per page of [begin, end), a read block at a time, until the
+        // range is resident or abandoned() fires. Returns how far it got.
+        size_t prefaultMapping(const ConstMemory& memory, size_t begin, size_t end,
+                               const std::function<bool()>& abandoned)
+        {
+            volatile u8 sink = 0;
+            size_t offset = begin;
+
+            for (; offset < end; offset += texture_read_block_size)
+            {
+                if (abandoned())
+                {
+                    return offset;
+                }
+
+                const size_t last = std::min(end, offset + texture_read_block_size);
+                u8 sum = 0;
+
+                for (size_t i = offset; i < last; i += 4096)
+                {
+                    sum += memory.address[i];
+                }
+
+                sink = sink + sum;
+            }
+
+            return end;
+        }
+
     } // namespace
 
     // -----------------------------------------------------------------------
@@ -340,7 +389,14 @@ namespace ifap
         static const u8 placeholder_pixel[] = { 32, 32, 32, 255 };
         m_placeholder = m_renderer.createTexture(1, 1, PixelFormat::RGBA8_UNORM, placeholder_pixel);
 
-        m_worker = std::thread([this] { workerThreadMain(); });
+        for (size_t lane = 0; lane < std::max(size_t(1), texture_prepare_max_lanes); ++lane)
+        {
+            // No ring at all while the reads are switched off.
+            m_readers.push_back(texture_async_reads ?
+                std::make_unique<AsyncFileReader>(texture_read_queue_depth, texture_read_request_size) : nullptr);
+            m_workers.emplace_back([this, lane] { workerThreadMain(lane); });
+        }
+
         m_reaper = std::thread([this] { reaperThreadMain(); });
     }
 
@@ -348,17 +404,22 @@ namespace ifap
     {
         shutdown();
 
+        m_provisional.reset();
         m_cache.clear();
         m_pinned.clear();
         m_pin_set.clear();
-        clearPartialReads();
+        m_file_cache.clear();
 
         {
             std::lock_guard lock(m_worker_mutex);
             m_worker_running = false;
         }
         m_worker_cv.notify_all();
-        m_worker.join();
+
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
 
         {
             std::lock_guard lock(m_reaper_mutex);
@@ -380,6 +441,10 @@ namespace ifap
             m_renderer.destroyTexture(m_placeholder);
             m_placeholder = 0;
         }
+
+        const BlockPoolStats pool = blockPoolStats();
+        printLine(Print::Info, "TextureCache: block pool {} mapped, {} reused, {} unmapped, {} MB retained ({} minor page faults).",
+            pool.allocated, pool.reused, pool.released, pool.retained_bytes >> 20, pool.minor_faults);
     }
 
     TextureCache::operator const ImageFileIndexer& () const
@@ -404,6 +469,11 @@ namespace ifap
             }
         });
 
+        if (m_provisional && m_provisional->decoder)
+        {
+            m_provisional->decoder->cancel();
+        }
+
         {
             std::lock_guard lock(m_worker_mutex);
 
@@ -490,11 +560,12 @@ namespace ifap
         m_reaper_cv.notify_one();
     }
 
-    void TextureCache::workerThreadMain()
+    void TextureCache::workerThreadMain(size_t lane)
     {
-        // Prepare lane only: allocate target bitmaps and launch the async decode.
-        // Each job returns quickly (the decode itself runs on its own std::async
-        // thread), so navigation jobs queued here are picked up promptly.
+        // Prepare lane only: read the file, allocate target bitmaps and launch the
+        // async decode (which runs on its own std::async thread). Every lane takes
+        // from the front, so the visible image, queued there, goes to the first free
+        // lane.
         for (;;)
         {
             WorkerJob job;
@@ -502,9 +573,9 @@ namespace ifap
             {
                 std::unique_lock lock(m_worker_mutex);
 
-                m_worker_cv.wait(lock, [this]
+                m_worker_cv.wait(lock, [this, lane]
                 {
-                    return !m_worker_running || !m_worker_jobs.empty();
+                    return !m_worker_running || (lane < m_prepare_lanes && !m_worker_jobs.empty());
                 });
 
                 if (!m_worker_running && m_worker_jobs.empty())
@@ -528,8 +599,34 @@ namespace ifap
                 continue;
             }
 
-            runPrepare(job.task);
+            runPrepare(job.task, job.index, m_readers[lane].get());
+
+            // Failed, skipped or abandoned before the launch: nothing will decode.
+            if (job.task && !job.task->future.valid())
+            {
+                job.task->ticket.release();
+            }
+        }
+    }
+
+    void TextureCache::setPrepareLanes(const std::string& pathname)
+    {
+        const size_t native = nativePathLength(pathname);
+        const size_t lanes = std::clamp(texture_prepare_lanes ? texture_prepare_lanes :
+            deviceReadConcurrency(pathname.substr(0, native), m_workers.size()), size_t(1), m_workers.size());
+
+        {
+            std::lock_guard lock(m_worker_mutex);
+            if (m_prepare_lanes == lanes)
+            {
+                return;
+            }
+
+            m_prepare_lanes = lanes;
         }
+
+        m_worker_cv.notify_all();
+        printLine(Print::Info, "TextureCache: {} prepare lane{}.", lanes, lanes > 1 ? "s" : "");
     }
 
     void TextureCache::reaperThreadMain()
@@ -562,7 +659,7 @@ namespace ifap
         }
     }
 
-    void TextureCache::runPrepare(const std::shared_ptr<DecodeTask>& task)
+    void TextureCache::runPrepare(const std::shared_ptr<DecodeTask>& task, size_t index, AsyncFileReader* reader)
     {
         if (!task || m_shutdown || (m_should_abort && m_should_abort()))
         {
@@ -576,88 +673,253 @@ namespace ifap
         {
             if (trace_decode)
             {
-                printLine("[trace] #{} skip-orphan (use_count={})", task->index, task.use_count());
+                printLine("[trace] #{} skip-orphan (use_count={})", index, task.use_count());
             }
             return;
         }
 
+        task->prepare_start_ms.store(mango::Time::ms());
+
         try
         {
             // Bulk, sequential read of the whole compressed file into RAM, on this worker
             // thread (never the UI thread). Going through File(path, name) preserves the
             // custom-mapper / archive support setCurrentPath() relies on; copying its
             // memory into a Buffer forces one sequential read and lets us drop the mapping
-            // immediately, so the decode below never has to touch the disk again. The
-            // single worker serialises these reads (one file at a time, spinning-disk
-            // friendly) while the launched decodes run in parallel on the decode pool.
+            // immediately, so the decode below never has to touch the disk again. On a
+            // spinning disk a single lane serialises these reads (one file at a time);
+            // faster devices get several lanes (see setPrepareLanes). The launched
+            // decodes run in parallel on the decode pool either way.
             //
             // The copy runs in blocks with an abort/abandonment check between them: if the
             // user scrolled past this image while a large read was in progress, we bail
             // here and stash the prefix so a later prepare for the same index can resume
             // instead of re-reading from offset 0.
+            auto abandoned = [this, &task]
             {
-                std::lock_guard lock(filesystem_mutex);
+                return m_shutdown || (m_should_abort && m_should_abort()) || task.use_count() <= 1;
+            };
 
+            ContainerSlices::Slice stream; // mapping still being faulted in
+            size_t stream_offset = 0;
+
+            {
                 if (!task->path)
                 {
                     return;
                 }
 
-                File file(*task->path, task->name);
-                ConstMemory src = file;
+                const std::string pathname = task->path->pathname() + task->name;
 
-                PartialFileRead partial = takePartialRead(task->index);
-                std::unique_ptr<Buffer> buffer;
-                size_t offset = 0;
+                // A member the container pool is inflating: let it finish rather than
+                // extract it a second time. Waited for unlocked, so the indexer can use
+                // the container meanwhile.
+                m_container_pool.wait(index, abandoned);
 
-                if (partial.buffer && partial.buffer->size() == src.size &&
-                    partial.bytes > 0 && partial.bytes <= src.size)
+                // Only contends with the indexer when both are inside the same container.
+                // Held while the mapper is in use (opening the file or the decoder), not
+                // across the copy, io_uring read or prefault; except that where native
+                // mappings are locked too (Windows) a File is copied and unmapped under it.
+                const bool lock_mapping = FilesystemLock::locksNativePaths();
+                std::optional<FilesystemLock> lock;
+
+                auto lockFilesystem = [&]
                 {
-                    buffer = std::move(partial.buffer);
-                    offset = partial.bytes;
+                    lock.emplace(pathname);
 
-                    if (trace_decode)
+                    if (trace_decode && lock->waited())
                     {
-                        printLine("[trace] #{} resume-read @ {} / {}",
-                            task->index, offset, src.size);
+                        printLine("[trace] #{} filesystem-lock wait {} us", index, lock->waited());
                     }
-                }
-                else
+                };
+
+                // Bytes kept from an earlier read of the same file: a complete entry skips
+                // the I/O entirely, a partial one is resumed below.
+                task->file_stamp = IndexCache::stamp(pathname);
+                FileCache::Entry cached = m_file_cache.take(index, pathname, task->file_stamp);
+
+                ContainerSlices::Slice slice;
+                ConstMemory source;
+
+                if (!cached.complete())
                 {
-                    buffer = std::make_unique<Buffer>(src.size);
+                    lockFilesystem();
+                    slice = mapFile(pathname);
+                    lock.reset();
                 }
 
-                u8* dst = buffer->data();
-                bool aborted = false;
-
-                for (; offset < src.size; offset += texture_read_block_size)
+                if (cached.complete())
                 {
-                    if (m_shutdown || (m_should_abort && m_should_abort()) || task.use_count() <= 1)
+                    if (trace_decode)
                     {
-                        aborted = true;
-                        break;
+                        printLine("[trace] #{} file-cache hit ({} bytes)", index, cached.bytes);
                     }
 
-                    const size_t block = std::min(texture_read_block_size, src.size - offset);
-                    std::memcpy(dst + offset, src.address + offset, block);
+                    task->read_bytes = cached.bytes;
+                    task->read_end_ms.store(mango::Time::ms());
+                    task->buffer = std::move(cached.buffer);
+                    source = *task->buffer;
                 }
 
-                task->read_bytes = offset;
+                // Large files on a local mount, and stored members of a local container,
+                // are decoded straight from a retained mapping: no copy, so peak RAM is
+                // the file once. Prefaulting in blocks keeps the abort check; an abandoned
+                // prefault needs no stash, the page cache keeps what was read. With
+                // streaming only the head is faulted in here; the rest follows the decode
+                // launch below.
+                else if (slice)
+                {
+                    const ConstMemory memory = slice.memory;
+                    const size_t head = texture_streaming_decode ?
+                        std::min(memory.size, texture_stream_head_size) : memory.size;
+                    const size_t offset = prefaultMapping(memory, 0, head, abandoned);
+
+                    task->read_bytes = offset;
+
+                    if (offset < head)
+                    {
+                        if (trace_decode)
+                        {
+                            printLine("[trace] #{} abort-prefault @ {} / {}",
+                                index, offset, memory.size);
+                        }
+                        return;
+                    }
+
+                    if (offset < memory.size)
+                    {
+                        stream = slice;
+                        stream_offset = offset;
+                    }
+                    else
+                    {
+                        task->read_end_ms.store(mango::Time::ms());
+                    }
 
-                if (aborted)
+                    task->mapping = std::move(slice.mapping);
+                    source = memory;
+                }
+                else
                 {
-                    if (trace_decode)
+                    // Native files go through the io_uring reader; containers (and any
+                    // failure there) through a File mapping.
+                    u64 native_size = 0;
+                    const bool native = reader && reader->valid() &&
+                        nativePathLength(pathname) == pathname.size() && reader->open(pathname, native_size);
+
+                    std::unique_ptr<File> file;
+                    ConstMemory src;
+
+                    if (!native)
                     {
-                        printLine("[trace] #{} abort-read @ {} / {}",
-                            task->index, offset, src.size);
+                        lockFilesystem();
+                        file = std::make_unique<File>(*task->path, task->name);
+                        if (!lock_mapping)
+                        {
+                            lock.reset();
+                        }
+                        src = *file;
                     }
 
-                    stashPartialRead(task->index, std::move(buffer), offset);
-                    return;
+                    const size_t size = native ? size_t(native_size) : src.size;
+
+                    std::unique_ptr<PooledBuffer> buffer;
+                    size_t offset = 0;
+
+                    if (cached.buffer && cached.buffer->size() == size &&
+                        cached.bytes > 0 && cached.bytes <= size)
+                    {
+                        buffer = std::move(cached.buffer);
+                        offset = cached.bytes;
+
+                        if (trace_decode)
+                        {
+                            printLine("[trace] #{} resume-read @ {} / {}",
+                                index, offset, size);
+                        }
+                    }
+                    else
+                    {
+                        buffer = std::make_unique<PooledBuffer>(size);
+                    }
+
+                    u8* dst = buffer->data();
+                    bool aborted = false;
+
+                    if (native)
+                    {
+                        const AsyncFileReader::Status status = reader->read(dst, offset, size, abandoned);
+                        reader->close();
+
+                        aborted = status == AsyncFileReader::Status::Aborted;
+
+                        if (status == AsyncFileReader::Status::Failed)
+                        {
+                            // Finish from a mapping; a file that changed size starts over.
+                            lockFilesystem();
+                            file = std::make_unique<File>(*task->path, task->name);
+                            if (!lock_mapping)
+                            {
+                                lock.reset();
+                            }
+                            src = *file;
+
+                            if (src.size != size)
+                            {
+                                buffer = std::make_unique<PooledBuffer>(src.size);
+                                dst = buffer->data();
+                                offset = 0;
+                            }
+                        }
+                    }
+
+                    if (file)
+                    {
+                        for (; offset < src.size; offset += texture_read_block_size)
+                        {
+                            if (abandoned())
+                            {
+                                aborted = true;
+                                break;
+                            }
+
+                            const size_t block = std::min(texture_read_block_size, src.size - offset);
+                            std::memcpy(dst + offset, src.address + offset, block);
+                        }
+
+                        offset = std::min(offset, src.size);
+                    }
+
+                    // Still held only with lock_mapping: unmap before releasing it.
+                    if (lock)
+                    {
+                        file.reset();
+                        lock.reset();
+                    }
+
+                    task->read_bytes = offset;
+
+                    if (aborted)
+                    {
+                        if (trace_decode)
+                        {
+                            printLine("[trace] #{} abort-read @ {} / {}",
+                                index, offset, buffer->size());
+                        }
+
+                        // Filed under the task's position once this prepare returns
+                        // (retainFileBytes), so a rekey during the read is not lost.
+                        task->buffer = std::move(buffer);
+                        return;
+                    }
+
+                    task->read_end_ms.store(mango::Time::ms());
+                    task->buffer = std::move(buffer);
+                    source = *task->buffer;
                 }
 
-                task->buffer = std::move(buffer);
-                task->decoder = std::make_unique<ImageDecoder>(*task->buffer, *task->path, task->name);
+                lockFilesystem();
+                task->decoder = std::make_unique<ImageDecoder>(source, *task->path, task->name);
             }
             ImageHeader header = task->decoder->header();
 
@@ -674,32 +936,29 @@ namespace ifap
             // Classify the file's colour signalling into a decode/upload plan: a fast GPU
             // format for BT.709 sRGB/linear content, or a CPU bake to scene-linear BT.709
             // fp16 for everything else (non-BT.709 primaries, odd transfer, explicit gamma).
-            const ColorPlan plan = classifyColor(header, task->decoder->icc());
+            ColorPlan plan = classifyColor(header, task->decoder->icc());
 
             const int max_texture_dimension = m_renderer.getMaxTextureDimension();
             const bool needs_downscale = max_texture_dimension > 0 &&
                 (header.width > max_texture_dimension || header.height > max_texture_dimension);
 
-            // The downscale preview path operates on 8-bit bitmaps; float (HDR) and baked
-            // (scene-linear fp16) sources have no preview yet.
-            if (needs_downscale && (header.format.isFloat() || plan.convert))
-            {
-                printLine(Print::Error, "{}: {} x {} exceeds GPU texture limit (max dimension: {}); float preview not supported yet",
-                    task->name, header.width, header.height, max_texture_dimension);
+            // Float (HDR) and baked sources are previewed in scene-linear fp16: the
+            // reducer converts and averages the decode rows, so neither the fp16 bake
+            // bitmap nor a full-resolution float bitmap is ever resident.
+            const bool linear_preview = needs_downscale && (header.format.isFloat() || plan.convert);
 
-                task->prepare_state = PrepareState::Failed;
-                if (m_on_content_changed)
-                {
-                    m_on_content_changed();
-                }
-                return;
+            // Any other preview uploads 8-bit, so a wider integer source (16-bit indexed
+            // or block-compressed) is decoded straight to 8-bit for the reducer.
+            if (needs_downscale && !linear_preview && plan.bitmap_format.bytes() != 4)
+            {
+                plan.bitmap_format = formatU8();
             }
 
             // Header-derived results go into the task's header_* staging fields, never
             // texture.* — those are promoted on the UI thread (promoteHeaderDims) so the
             // per-frame draw path never reads dims/format while we write them here.
             task->bitmap_format = plan.bitmap_format;
-            task->header_format = plan.upload_format;
+            task->header_format = linear_preview ? PixelFormat::RGBA16F : plan.upload_format;
             task->header_linear = plan.convert || plan.upload_format != PixelFormat::RGBA8_SRGB;
             task->header_needs_tonemap = isHdrContent(header, plan);
             task->needs_color_convert = plan.convert;
@@ -723,8 +982,9 @@ namespace ifap
                 task->header_sample_width = task->downscale_width;
                 task->header_sample_height = task->downscale_height;
 
-                task->scaled_bitmap = std::make_unique<Bitmap>(
-                    task->downscale_width, task->downscale_height, task->bitmap_format);
+                task->scaled_bitmap = std::make_unique<PooledBitmap>(
+                    task->downscale_width, task->downscale_height,
+                    linear_preview ? formatLinearDest() : task->bitmap_format);
             }
             else
             {
@@ -732,25 +992,64 @@ namespace ifap
                 task->header_sample_height = header.height;
             }
 
-            task->bitmap = std::make_unique<Bitmap>(
-                header.width, header.height, task->bitmap_format);
+            // Reduced while it streams in, one decoded rect at a time; with a sparse
+            // bitmap that is not kept for tiles only the rows in flight stay resident.
+            const bool reduce = task->downscale;
+            const bool sparse = reduce && texture_streaming_downscale;
+
+            // The visible image is kept whole for full-detail tiles when it fits the
+            // retained-decode budget (8-bit tiles only); prefetch stays sparse.
+            const bool visible = task->ticket.priority() == DecodeScheduler::Priority::Visible;
+            const u64 full_bytes = u64(header.width) * header.height * task->bitmap_format.bytes();
+            task->tiled = reduce && visible && !linear_preview && texture_virtual_tiles &&
+                full_bytes <= texture_virtual_source_bytes;
+
+            if (sparse)
+            {
+                task->bitmap = std::make_unique<PooledBitmap>(
+                    header.width, header.height, task->bitmap_format, PooledBuffer::Sparse());
+            }
+            else
+            {
+                task->bitmap = std::make_unique<PooledBitmap>(
+                    header.width, header.height, task->bitmap_format);
+            }
+
+            if (reduce)
+            {
+                task->reducer = std::make_unique<StreamingBoxReducer>(*task->bitmap, *task->scaled_bitmap, !task->tiled,
+                    plan.convert ? &task->header_color : nullptr);
+            }
 
             // Bake path: scene-linear fp16 result for the GPU; decode layout stays in
-            // bitmap_format (u8 encoded integer, or fp16/fp32 float).
-            if (task->needs_color_convert)
+            // bitmap_format (u8 encoded integer, or fp16/fp32 float). A preview is
+            // linearized by its reducer instead.
+            if (task->needs_color_convert && !task->downscale)
             {
-                task->convert_bitmap = std::make_unique<Bitmap>(
+                task->convert_bitmap = std::make_unique<PooledBitmap>(
                     header.width, header.height, formatLinearDest());
             }
 
+            // The probe's estimate (if any) becomes the real cost of this decode. A sparse
+            // bitmap that is not kept is mostly never resident.
+            u64 decode_bytes = sparse && !task->tiled ? 0 : u64(task->bitmap->stride) * task->bitmap->height;
+            for (const PooledBitmap* extra : { task->convert_bitmap.get(), task->scaled_bitmap.get() })
+            {
+                if (extra)
+                {
+                    decode_bytes += u64(extra->stride) * extra->height;
+                }
+            }
+
+            task->ticket.setBytes(decode_bytes);
             task->decode_start_ms.store(mango::Time::ms());
 
             if (trace_decode)
             {
-                printLine("[trace] #{} launch {} x {}", task->index, header.width, header.height);
+                printLine("[trace] #{} launch {} x {}", index, header.width, header.height);
             }
 
-            task->future = task->decoder->launch([this, task = task.get()] (const ImageDecodeRect& rect)
+            task->future = task->decoder->launch([this, task = task.get(), index] (const ImageDecodeRect& rect)
             {
                 if (m_shutdown || (m_should_abort && m_should_abort()))
                 {
@@ -770,7 +1069,13 @@ namespace ifap
                     }
                 }
 
+                if (task->reducer)
+                {
+                    task->reducer->consume(rect.x, rect.y, rect.width, rect.height);
+                }
+
                 bool first = false;
+                bool complete = false;
 
                 {
                     std::lock_guard lock(task->mutex);
@@ -781,17 +1086,25 @@ namespace ifap
                     }
                     task->updates.push_back(rect);
                     task->progress += rect.progress;
+                    complete = task->progress >= 1.0f;
                 }
 
                 if (trace_decode && first)
                 {
-                    printLine("[trace] #{} first-pixels", task->index);
+                    printLine("[trace] #{} first-pixels", index);
                 }
 
                 if (m_on_content_changed)
                 {
                     m_on_content_changed();
                 }
+
+                // Every pixel is out: hand the pipeline slot on now rather than when the
+                // UI thread next sees the future ready.
+                if (complete)
+                {
+                    task->ticket.release();
+                }
             }, *task->bitmap);
 
             if (m_shutdown || (m_should_abort && m_should_abort()))
@@ -806,6 +1119,26 @@ namespace ifap
             {
                 m_on_content_changed();
             }
+
+            // Streaming: the decode is running and trails this loop; a page it reaches
+            // first just faults in. Holding `stream` keeps the mapping valid even if the
+            // UI thread drops task->mapping after the decode completes. Stopping early
+            // is harmless for the same reason.
+            if (stream)
+            {
+                const ConstMemory memory = stream.memory;
+                const size_t offset = prefaultMapping(memory, stream_offset, memory.size, abandoned);
+
+                if (offset == memory.size)
+                {
+                    task->read_end_ms.store(mango::Time::ms());
+                }
+
+                if (trace_decode)
+                {
+                    printLine("[trace] #{} stream-read {} / {}", index, offset, memory.size);
+                }
+            }
         }
         catch (...)
         {
@@ -813,6 +1146,17 @@ namespace ifap
         }
     }
 
+    void TextureCache::retainFileBytes(DecodeTask& task)
+    {
+        // The decoder is gone, so nothing reads the buffer any more.
+        if (task.buffer && task.path && task.index < unresolved_index)
+        {
+            m_file_cache.put(task.index, { task.path->pathname() + task.name, task.file_stamp, std::move(task.buffer), task.read_bytes });
+        }
+
+        task.buffer.reset();
+    }
+
     void TextureCache::runDispose(WorkerJob job)
     {
         DecodeTask* raw = job.task.get();
@@ -829,7 +1173,8 @@ namespace ifap
             raw->convert_bitmap.reset();
             raw->scaled_bitmap.reset();
             raw->decoder.reset();
-            raw->buffer.reset();
+            retainFileBytes(*raw);
+            raw->mapping.reset();
         }
 
         job.task.reset();
@@ -940,62 +1285,6 @@ namespace ifap
         m_prefetch_direction = direction;
     }
 
-    void TextureCache::stashPartialRead(size_t index, std::unique_ptr<Buffer> buffer, size_t bytes)
-    {
-        if (!buffer || bytes == 0)
-        {
-            return;
-        }
-
-        std::lock_guard lock(m_partial_mutex);
-
-        m_partial_reads[index] = PartialFileRead{ std::move(buffer), bytes };
-
-        // Bound retained prefixes so a fast scroll across huge files cannot pin an
-        // unbounded amount of host RAM. Keep the entry we just stashed; drop others
-        // until we are within the prefetch window (+ the visible image).
-        const size_t limit = texture_prefetch_size + 1;
-        while (m_partial_reads.size() > limit)
-        {
-            bool erased = false;
-            for (auto it = m_partial_reads.begin(); it != m_partial_reads.end(); ++it)
-            {
-                if (it->first != index)
-                {
-                    m_partial_reads.erase(it);
-                    erased = true;
-                    break;
-                }
-            }
-
-            if (!erased)
-            {
-                break;
-            }
-        }
-    }
-
-    TextureCache::PartialFileRead TextureCache::takePartialRead(size_t index)
-    {
-        std::lock_guard lock(m_partial_mutex);
-
-        auto it = m_partial_reads.find(index);
-        if (it == m_partial_reads.end())
-        {
-            return {};
-        }
-
-        PartialFileRead partial = std::move(it->second);
-        m_partial_reads.erase(it);
-        return partial;
-    }
-
-    void TextureCache::clearPartialReads()
-    {
-        std::lock_guard lock(m_partial_mutex);
-        m_partial_reads.clear();
-    }
-
     void TextureCache::abortNonPriorityWork(size_t priority_index)
     {
         // Navigation just settled on (or jumped to) priority_index. Drop every other
@@ -1062,12 +1351,12 @@ namespace ifap
             for (WorkerJob& job : m_worker_jobs)
             {
                 if (job.type == WorkerJob::Type::Prepare && job.task &&
-                    job.task->index != priority_index)
+                    job.index != priority_index)
                 {
                     if (trace_decode)
                     {
                         printLine("[trace] #{} drop-queued (priority #{})",
-                            job.task->index, priority_index);
+                            job.index, priority_index);
                     }
                     continue;
                 }
@@ -1277,7 +1566,10 @@ namespace ifap
         }
 
         task.decode_logged = true;
+        task.ticket.release();
 
+        const u64 prepare = task.prepare_start_ms.load();
+        const u64 read_end = task.read_end_ms.load();
         const u64 start = task.decode_start_ms.load();
         const u64 first = task.decode_first_ms.load();
         const u64 end = mango::Time::ms();
@@ -1287,34 +1579,36 @@ namespace ifap
             return;
         }
 
+        // Time to first pixels counts from the prepare pickup, so it includes the read;
+        // with a streaming read it can land before the read finished.
         printLine(Print::Info, "[decode] {}: total {} ms, first pixels {} ms ({} x {})",
             task.name,
             end - start,
             first ? (first - start) : 0,
             task.header_width, task.header_height);
+        printLine(Print::Info, "[decode] {}: time to first pixels {} ms, read {} ms{}",
+            task.name,
+            first && prepare ? (first - prepare) : 0,
+            read_end && prepare ? (read_end - prepare) : 0,
+            read_end > start ? " (streamed)" : "");
     }
 
-    size_t TextureCache::countActiveDecodes() const
+    void TextureCache::prioritize(const std::shared_ptr<DecodeTask>& task)
     {
-        size_t active = 0;
-
-        for (const auto& entry : m_pinned)
+        // The previously visible image keeps decoding as near prefetch.
+        std::shared_ptr<DecodeTask> previous = m_visible_task.lock();
+        if (!task || previous == task)
         {
-            if (entry.second && entry.second->isDecoding())
-            {
-                ++active;
-            }
+            return;
         }
 
-        m_cache.for_each([&active] (size_t /*index*/, const std::shared_ptr<DecodeTask>& task)
+        if (previous)
         {
-            if (task && task->isDecoding())
-            {
-                ++active;
-            }
-        });
+            previous->ticket.setPriority(DecodeScheduler::Priority::Near);
+        }
 
-        return active;
+        task->ticket.setPriority(DecodeScheduler::Priority::Visible);
+        m_visible_task = task;
     }
 
     void TextureCache::tickPrefetch(size_t priority_index)
@@ -1326,7 +1620,7 @@ namespace ifap
         }
 
         // Hold prefetch until the visible image has finished prepare (chunked file
-        // read + decode launch). While it is still Preparing, the single worker is
+        // read + decode launch). While it is still Preparing, a prepare lane is
         // either reading it or about to; competing I/O would recreate the gray-screen
         // stall that abortNonPriorityWork() just cleared.
         auto priority_task = lookupTask(priority_index);
@@ -1336,14 +1630,6 @@ namespace ifap
             return;
         }
 
-        // Don't pile on more decodes while the pipeline is already saturated. This
-        // keeps the visible image's decode from being starved by prefetch and bounds
-        // the number of full-resolution bitmaps held in memory at once.
-        if (countActiveDecodes() >= texture_inflight_decode_limit)
-        {
-            return;
-        }
-
         const size_t count = m_indexer.size();
         if (!count)
         {
@@ -1359,41 +1645,298 @@ namespace ifap
                 continue;
             }
 
+            // Don't pile on more decodes while the pipeline is saturated: by count, and
+            // by byte cost where the header probe knows it (a few huge images saturate
+            // memory and the decode pool long before the count limit does). The
+            // scheduler publishes its occupancy, so this is a couple of atomic loads.
+            const DecodeScheduler::Priority priority = i < (texture_prefetch_size + 1) / 2 ?
+                DecodeScheduler::Priority::Near : DecodeScheduler::Priority::Far;
+
+            ImageMetadata metadata;
+            const u64 bytes = m_indexer.metadata(index, metadata) ? metadata.decodedBytes() : 0;
+
+            if (!m_scheduler.admissible(priority, bytes))
+            {
+                return;
+            }
+
             getTexture(index);
+
+            if (std::shared_ptr<DecodeTask> task = lookupTask(index))
+            {
+                task->ticket.setPriority(priority);
+            }
             return;
         }
     }
 
-    void TextureCache::uploadDownscaledPreview(DecodeTask& task)
+    void TextureCache::trimTileSources(size_t priority_index)
     {
-        GpuTexture& texture = task.texture;
+        // Full-resolution decodes kept for tiles, nearest the visible image first. Past
+        // the budget the finished ones are dropped and fall back to their preview.
+        // Distance wraps around the list like navigation does (see tickPrefetch).
+        std::vector<std::pair<size_t, DecodeTask*>> sources;
+        const size_t count = m_indexer.size();
+
+        forEachTask([&sources, priority_index, count] (size_t index, std::shared_ptr<DecodeTask>& task)
+        {
+            if (task->tiled && task->bitmap)
+            {
+                size_t distance = index > priority_index ? index - priority_index : priority_index - index;
 
-        if (!task.bitmap || !task.scaled_bitmap)
+                if (index < count && priority_index < count)
+                {
+                    const size_t forward = (index + count - priority_index) % count;
+                    const size_t backward = (priority_index + count - index) % count;
+                    distance = std::min(forward, backward);
+                }
+
+                sources.emplace_back(distance, task.get());
+            }
+        });
+
+        std::sort(sources.begin(), sources.end(), [] (const auto& a, const auto& b)
+        {
+            return a.first < b.first;
+        });
+
+        u64 retained = 0;
+
+        for (auto& [distance, task] : sources)
+        {
+            const u64 bytes = u64(task->bitmap->stride) * task->bitmap->height;
+
+            if (distance && !task->reducer && retained + bytes > texture_virtual_source_bytes)
+            {
+                task->bitmap.reset();
+                task->tiled = false;
+                continue;
+            }
+
+            retained += bytes;
+        }
+    }
+
+    void TextureCache::scheduleReadahead(size_t priority_index)
+    {
+        // Once per navigation step: the lanes work through their lists on their own.
+        if (!m_current_path ||
+            (priority_index == m_readahead_index && m_prefetch_direction == m_readahead_direction))
         {
             return;
         }
 
-        const bool needs_create = !task.gpu_texture_ready;
-        const u64 now = mango::Time::ms();
+        m_readahead_index = priority_index;
+        m_readahead_direction = m_prefetch_direction;
 
-        if (!needs_create && now - task.last_preview_ms < 50)
+        scheduleSolidExtraction(priority_index);
+        scheduleContainerExtraction(priority_index);
+
+        if (!m_prefetch_direction)
         {
             return;
         }
 
-        task.last_preview_ms = now;
+        const size_t count = m_indexer.size();
+        const size_t files = std::min(texture_readahead_count, count ? count - 1 : 0);
 
-        const int dw = task.downscale_width;
-        const int dh = task.downscale_height;
+        std::vector<std::string> pathnames;
+        pathnames.reserve(files);
 
-        u32_bicubic_blit(*task.scaled_bitmap, *task.bitmap,
-            0.5f, 0.5f, float(dw) - 1.0f, float(dh) - 1.0f);
+        const std::string& prefix = m_current_path->pathname();
 
-        if (needs_create)
+        for (size_t i = 0; i < files; ++i)
         {
-            TextureHandle created = m_renderer.createTexture(dw, dh, texture.format, task.scaled_bitmap->image);
+            const size_t index = modulo(priority_index + (i + 1) * size_t(m_prefetch_direction), count);
 
-            if (!created)
+            // Unopened containers have nothing to warm yet.
+            const FilenameTable::View view = m_indexer[index];
+            if (view.name.empty())
+            {
+                continue;
+            }
+
+            pathnames.push_back(prefix + view.str());
+        }
+
+        m_readahead.request(std::move(pathnames), texture_readahead_bytes);
+    }
+
+    void TextureCache::scheduleSolidExtraction(size_t priority_index)
+    {
+        const size_t count = m_indexer.size();
+        if (priority_index >= count)
+        {
+            return;
+        }
+
+        const std::string& prefix = m_current_path->pathname();
+        const std::string pathname = prefix + m_indexer[priority_index].str();
+
+        // Only members directly inside a native container file.
+        const size_t native = nativePathLength(pathname);
+        if (native == pathname.size())
+        {
+            return;
+        }
+
+        const std::string container = pathname.substr(0, native);
+
+        if (cachedContainerKind(container) != ContainerKind::SolidRar)
+        {
+            return;
+        }
+
+        // The solid stream only runs forward, and the index lists a container's members
+        // together in order: take the ones after the current member, whichever way the
+        // user is paging.
+        std::vector<SolidArchiveExtractor::Member> members;
+        const std::string member_prefix = container + "/";
+
+        for (size_t index = priority_index + 1; index < count && members.size() < texture_solid_extract_count; ++index)
+        {
+            const FilenameTable::View view = m_indexer[index];
+            std::string name = view.str();
+
+            if ((prefix + name).compare(0, member_prefix.size(), member_prefix))
+            {
+                break;
+            }
+
+            members.push_back({ index, std::move(name) });
+        }
+
+        if (!members.empty())
+        {
+            m_extractor.request(m_current_path, std::move(members), IndexCache::stamp(container),
+                                texture_solid_extract_bytes);
+        }
+    }
+
+    ContainerSlices::Slice TextureCache::mapFile(const std::string& pathname)
+    {
+        const size_t native = nativePathLength(pathname);
+
+        if (native < pathname.size())
+        {
+            if (!texture_stored_slices)
+            {
+                return {};
+            }
+
+            const std::string container = pathname.substr(0, native);
+            ContainerSlices::Slice slice = m_slices.find(container, pathname.substr(native + 1),
+                                                         IndexCache::stamp(container));
+            if (slice)
+            {
+                adviseSequential(slice.memory.address, slice.memory.size);
+            }
+
+            return slice;
+        }
+
+        ContainerSlices::Slice slice;
+
+        if (std::shared_ptr<File> file = mapLocalFile(pathname))
+        {
+            slice.memory = *file;
+            slice.mapping = std::move(file);
+        }
+
+        return slice;
+    }
+
+    void TextureCache::scheduleContainerExtraction(size_t priority_index)
+    {
+        const size_t count = m_indexer.size();
+        if (priority_index >= count)
+        {
+            return;
+        }
+
+        const std::string& prefix = m_current_path->pathname();
+        std::vector<ContainerExtractPool::Job> jobs;
+
+        // The visible image, then the prefetch window in navigation order.
+        const size_t window = m_prefetch_direction ? std::min(texture_prefetch_size, count - 1) : 0;
+
+        for (size_t i = 0; i <= window; ++i)
+        {
+            const size_t index = modulo(priority_index + i * size_t(m_prefetch_direction), count);
+            const std::string pathname = prefix + m_indexer[index].str();
+
+            const size_t native = nativePathLength(pathname);
+            if (native == pathname.size())
+            {
+                continue;
+            }
+
+            ContainerExtractPool::Job job;
+            job.index = index;
+            job.pathname = pathname;
+            job.container = pathname.substr(0, native);
+            job.member = pathname.substr(native + 1);
+
+            // Nested containers are inflated through their parent by the prepare worker.
+            if (nativePathLength(job.member) < job.member.size() ||
+                cachedContainerKind(job.container) != ContainerKind::Zip)
+            {
+                continue;
+            }
+
+            job.stamp = IndexCache::stamp(job.container);
+            jobs.push_back(std::move(job));
+        }
+
+        m_container_pool.request(std::move(jobs));
+    }
+
+    ContainerKind TextureCache::cachedContainerKind(const std::string& container)
+    {
+        auto it = m_container_kinds.find(container);
+        if (it == m_container_kinds.end())
+        {
+            it = m_container_kinds.emplace(container, containerKind(container)).first;
+        }
+
+        return it->second;
+    }
+
+    void TextureCache::uploadDownscaledPreview(DecodeTask& task)
+    {
+        GpuTexture& texture = task.texture;
+
+        // Every preview is reduced on the decode threads (see runPrepare).
+        if (!task.reducer || !task.scaled_bitmap)
+        {
+            return;
+        }
+
+        const bool needs_create = !task.gpu_texture_ready;
+        const u64 now = mango::Time::ms();
+
+        if (!needs_create && now - task.last_preview_ms < 50)
+        {
+            return;
+        }
+
+        task.last_preview_ms = now;
+
+        const int dw = task.downscale_width;
+        const int dh = task.downscale_height;
+
+        // Upload the rows finished since the last preview (all of them again after a
+        // rewind).
+        const int ready = task.reducer->ready();
+        if (task.reducer->takeRewind())
+        {
+            task.preview_rows = 0;
+        }
+
+        if (needs_create)
+        {
+            TextureHandle created = m_renderer.createTexture(dw, dh, texture.format, task.scaled_bitmap->image);
+            if (!created)
             {
                 // VRAM exhaustion: keep the placeholder, retry on a later frame.
                 return;
@@ -1402,6 +1945,7 @@ namespace ifap
             TextureHandle placeholder = texture.handle;
             texture.handle = created;
             task.gpu_texture_ready = true;
+            task.preview_rows = ready;
 
             if (placeholder && placeholder != m_placeholder)
             {
@@ -1412,16 +1956,28 @@ namespace ifap
             return;
         }
 
-        m_renderer.uploadTextureRegion(texture.handle, texture.format,
-            0, 0, dw, dh, task.scaled_bitmap->image);
+        if (ready > task.preview_rows)
+        {
+            const int y = task.preview_rows;
+            m_renderer.uploadTextureRegion(texture.handle, texture.format, 0, y, dw, ready - y,
+                task.scaled_bitmap->image + size_t(y) * task.scaled_bitmap->stride);
+            task.preview_rows = ready;
+        }
     }
 
     size_t TextureCache::setCurrentPath(const std::string& name)
     {
+        m_readahead.clear();
+        m_readahead_index = size_t(-1);
+        m_extractor.clear();
+        m_container_kinds.clear();
+        m_container_pool.clear();
+        m_slices.clear();
+        m_provisional.reset();
         m_cache.clear();
         m_pinned.clear();
         m_pin_set.clear();
-        clearPartialReads();
+        m_file_cache.clear();
 
         std::string filename = name;
         const std::string pathname = getPath(filename);
@@ -1458,79 +2014,271 @@ namespace ifap
             filename.clear();
         }
 
-        size_t m_current_index = -1u;
+        setPrepareLanes(m_current_path->pathname());
+        m_indexer_generation = m_indexer.generation();
 
-        if (filename.empty())
+        if (!filename.empty())
         {
-            auto getIndexOfFirstFile = [this] () -> size_t
+            // Do not wait for the walk to reach the opened file: it lives in the root
+            // folder, so its name is already known. Prepare it now and let syncIndexer()
+            // give it a position once the indexer publishes it.
+            m_provisional = launchTask(filename, unresolved_index, true);
+            return unresolved_index;
+        }
+
+        // The indexer's name -> position map answers as soon as the name is published;
+        // an empty filename resolves to the first file found.
+        size_t m_current_index = m_indexer.waitFor(filename, m_should_abort);
+
+        return m_current_index;
+    }
+
+    void TextureCache::rekeyTasks(const std::function<size_t(DecodeTask&)>& remap)
+    {
+        // Collect every task with its store, then rebuild both stores under the new keys.
+        // Decoded images keep their textures; tasks that map to -1 are dropped (the
+        // deleter routes them to the reaper as usual).
+        std::vector<std::pair<std::shared_ptr<DecodeTask>, bool>> tasks;
+
+        for (auto& entry : m_pinned)
+        {
+            tasks.emplace_back(entry.second, true);
+        }
+
+        m_cache.for_each([&tasks] (size_t /*index*/, std::shared_ptr<DecodeTask>& task)
+        {
+            tasks.emplace_back(task, false);
+        });
+
+        m_pinned.clear();
+        m_cache.clear();
+
+        std::vector<size_t> pin_set;
+
+        for (auto& [task, pinned] : tasks)
+        {
+            if (!task)
             {
-                bool done = false;
-                bool last = false;
+                continue;
+            }
 
-                while (!done)
-                {
-                    if (m_should_abort && m_should_abort())
-                    {
-                        return -1u;
-                    }
+            task->index = remap(*task);
+            if (task->index == size_t(-1))
+            {
+                continue;
+            }
 
-                    if (m_indexer.size() > 0)
-                    {
-                        return 0;
-                    }
+            if (pinned)
+            {
+                m_pinned[task->index] = task;
+                pin_set.push_back(task->index);
+            }
+            else
+            {
+                m_cache.insert(task->index, task);
+            }
+        }
 
-                    mango::Sleep::ms(50);
+        m_pin_set = std::move(pin_set);
 
-                    done = last;
-                    last = !m_indexer.isRunning();
-                }
+        refreshQueuedPrepares();
+    }
 
-                return -1u;
-            };
+    void TextureCache::refreshQueuedPrepares()
+    {
+        // A queued prepare has not read anything yet, so it simply takes the new
+        // position. A running one keeps the position it started with; what it reads is
+        // filed under the task's position after it returns (retainFileBytes).
+        std::lock_guard lock(m_worker_mutex);
 
-            m_current_index = getIndexOfFirstFile();
+        for (WorkerJob& job : m_worker_jobs)
+        {
+            if (job.type == WorkerJob::Type::Prepare && job.task)
+            {
+                job.index = job.task->index;
+            }
         }
-        else
+    }
+
+    void TextureCache::remapByName(size_t& index)
+    {
+        std::string current_name;
+        if (auto current = lookupTask(index))
         {
-            auto getIndexFromFilename = [this] (const std::string& filename) -> size_t
+            current_name = current->name;
+        }
+
+        const size_t count = m_indexer.size();
+
+        rekeyTasks([this] (DecodeTask& task)
+        {
+            return m_indexer.find(task.name);
+        });
+
+        // Cached file bytes follow their pathname to its new position.
+        const std::string& prefix = m_current_path ? m_current_path->pathname() : std::string();
+
+        m_file_cache.remap([this, &prefix] (size_t, const std::string& pathname)
+        {
+            if (pathname.compare(0, prefix.size(), prefix))
             {
-                size_t position = 0;
+                return size_t(-1);
+            }
+            return m_indexer.find(std::string_view(pathname).substr(prefix.size()));
+        });
 
-                bool done = false;
-                bool last = false;
+        const size_t moved = current_name.empty() ? size_t(-1) : m_indexer.find(current_name);
+        if (moved != size_t(-1))
+        {
+            index = moved;
+        }
+        else if (count)
+        {
+            index = std::min(index, count - 1);
+        }
+    }
 
-                while (!done)
+    void TextureCache::remapByEdits(const std::vector<IndexEdit>& edits, size_t& index)
+    {
+        auto follow = [&edits] (size_t position) -> size_t
+        {
+            for (const IndexEdit& edit : edits)
+            {
+                position = remapIndex(edit, position);
+                if (position == size_t(-1))
                 {
-                    if (m_should_abort && m_should_abort())
-                    {
-                        return -1u;
-                    }
-
-                    for ( ; position < m_indexer.size(); ++position)
-                    {
-                        if (m_indexer[position] == filename)
-                        {
-                            return position;
-                        }
-                    }
+                    break;
+                }
+            }
+            return position;
+        };
 
-                    mango::Sleep::ms(5);
+        rekeyTasks([&] (DecodeTask& task) -> size_t
+        {
+            const size_t position = follow(task.index);
+            if (position == size_t(-1))
+            {
+                return position;
+            }
 
-                    done = last;
-                    last = !m_indexer.isRunning();
+            // Renamed file: keep the decoded image under its new name. A prepare still
+            // in flight reads the name on the worker, so that one is dropped instead.
+            const FilenameTable::View name = m_indexer[position];
+            if (name != task.name)
+            {
+                if (task.prepare_state == PrepareState::Preparing)
+                {
+                    return size_t(-1);
                 }
+                task.name = name.str();
+            }
 
-                return -1u;
-            };
+            return position;
+        });
 
-            m_current_index = getIndexFromFilename(filename);
+        m_file_cache.remap([&follow] (size_t position, const std::string&)
+        {
+            return follow(position);
+        });
+
+        // The current position follows its file; if the file itself was removed it
+        // stays put, which now names the file that followed it.
+        for (const IndexEdit& edit : edits)
+        {
+            const size_t position = remapIndex(edit, index);
+            if (position != size_t(-1))
+            {
+                index = position;
+            }
         }
 
-        return m_current_index;
+        const size_t count = m_indexer.size();
+        if (count)
+        {
+            index = std::min(index, count - 1);
+        }
+    }
+
+    bool TextureCache::resolveProvisional(size_t& index)
+    {
+        const size_t position = m_indexer.find(m_provisional->name);
+
+        if (position == size_t(-1))
+        {
+            if (m_indexer.isRunning())
+            {
+                return false;
+            }
+
+            // The walk finished without it (unreadable or filtered out); fall back to
+            // the first indexed file.
+            m_provisional.reset();
+            index = m_indexer.size() ? 0 : unresolved_index;
+            return true;
+        }
+
+        std::shared_ptr<DecodeTask> task = std::move(m_provisional);
+        task->index = position;
+        refreshQueuedPrepares();
+
+        // No other task exists yet (prefetch waits for a resolved index), so the list
+        // changes seen so far have nothing to remap.
+        m_indexer_generation = m_indexer.generation();
+        m_indexer.takeChanges();
+
+        repin(position);
+        storeTask(position, task, true);
+
+        if (trace_decode)
+        {
+            printLine("[trace] #{} resolved {}", position, task->name);
+        }
+
+        index = position;
+        return true;
+    }
+
+    bool TextureCache::syncIndexer(size_t& index)
+    {
+        if (m_provisional)
+        {
+            return resolveProvisional(index);
+        }
+
+        const size_t generation = m_indexer.generation();
+        if (generation == m_indexer_generation)
+        {
+            return false;
+        }
+
+        m_indexer_generation = generation;
+
+        IndexChanges changes = m_indexer.takeChanges();
+
+        if (changes.replaced)
+        {
+            remapByName(index);
+        }
+        else if (!changes.edits.empty())
+        {
+            remapByEdits(changes.edits, index);
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
     }
 
     std::shared_ptr<DecodeTask> TextureCache::getTexture(size_t index, bool priority)
     {
+        // Not indexed yet (see setCurrentPath): there is no window to pin around.
+        if (index == unresolved_index)
+        {
+            return m_provisional;
+        }
+
         // Navigation defines a new pin window (current image + prefetch window).
         // Establish it before lookup/creation so the visible image is routed to
         // the eviction-immune overlay and protected from this point on. Then abort
@@ -1543,21 +2291,37 @@ namespace ifap
             abortNonPriorityWork(index);
         }
 
+        // An unopened container: ask for it (and its neighbours) to be listed. The
+        // caller picks the real files up after syncIndexer().
+        if (m_indexer.isPlaceholder(index))
+        {
+            m_indexer.expandNear(index, texture_prefetch_size);
+            return {};
+        }
+
         auto entry = lookupTask(index);
         if (entry)
         {
             return entry;
         }
 
-        std::shared_ptr<DecodeTask> task = makeTask();
-
         if (index >= m_indexer.size())
         {
             return {};
         }
 
-        task->name = m_indexer[index];
+        std::shared_ptr<DecodeTask> task = launchTask(m_indexer[index].str(), index, priority);
+        storeTask(index, task, priority);
+        return task;
+    }
+
+    std::shared_ptr<DecodeTask> TextureCache::launchTask(std::string name, size_t index, bool priority)
+    {
+        std::shared_ptr<DecodeTask> task = makeTask();
+
+        task->name = std::move(name);
         task->index = index;
+        m_indexer.metadata(index, task->metadata);
 
         // Capture the current path so the worker can open the file even if the user
         // changes folder (setCurrentPath reassigns m_current_path) while this is queued.
@@ -1577,6 +2341,8 @@ namespace ifap
         texture.format = PixelFormat::RGBA8_UNORM;
 
         task->prepare_state = PrepareState::Preparing;
+        task->ticket = m_scheduler.admit(priority ? DecodeScheduler::Priority::Visible : DecodeScheduler::Priority::Near,
+            task->metadata.valid ? task->metadata.decodedBytes() : 0);
 
         if (trace_decode)
         {
@@ -1586,9 +2352,9 @@ namespace ifap
         WorkerJob job;
         job.type = WorkerJob::Type::Prepare;
         job.task = task;
+        job.index = index;
         enqueuePrepare(std::move(job), priority);
 
-        storeTask(index, task, priority);
         return task;
     }
 
@@ -1614,7 +2380,38 @@ namespace ifap
 
         if (task.downscale)
         {
-            if (!updates.empty() || !task.gpu_texture_ready)
+            if (task.reducer)
+            {
+                const bool decode_finished = !task.future.valid() ||
+                    task.future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+                if (decode_finished)
+                {
+                    task.reducer->finish();
+
+                    // Everything is on the GPU: the sparse source and the preview copy
+                    // are dead weight, as on the full-resolution path. A tiled source
+                    // stays for VirtualTexture (see trimTileSources).
+                    if (task.gpu_texture_ready && task.preview_rows >= task.downscale_height)
+                    {
+                        task.reducer.reset();
+                        if (!task.tiled)
+                        {
+                            task.bitmap.reset();
+                        }
+                        task.scaled_bitmap.reset();
+                        task.decoder.reset();
+                        retainFileBytes(task);
+                        task.mapping.reset();
+                        return false;
+                    }
+                }
+            }
+
+            // The reducer has already consumed the rects; only its finished rows matter.
+            const bool dirty = task.reducer && task.reducer->ready() > task.preview_rows;
+
+            if (dirty || !task.gpu_texture_ready)
             {
                 uploadDownscaledPreview(task);
                 return true;
@@ -1625,7 +2422,7 @@ namespace ifap
 
         // On the bake path the GPU samples the scene-linear BT.709 result, not the raw
         // decode; the decode-thread callback has already converted each published rect.
-        Bitmap* source = task.needs_color_convert ? task.convert_bitmap.get() : task.bitmap.get();
+        Surface* source = task.needs_color_convert ? task.convert_bitmap.get() : task.bitmap.get();
 
         if (!texture.handle || updates.empty() || !source)
         {
@@ -1695,7 +2492,8 @@ namespace ifap
             // references the buffer) and then the buffer itself. This is what bounds the
             // extra "whole compressed file in RAM" cost of bulk reads to in-flight decodes.
             task.decoder.reset();
-            task.buffer.reset();
+            retainFileBytes(task);
+            task.mapping.reset();
 
             // The image is fully on the GPU; the upload staging buffers are no longer
             // needed, so reclaim them too (the CPU bitmap above was the larger cost,
@@ -1721,6 +2519,21 @@ namespace ifap
         // textures are safely requeued by tryDestroyTexture.
         drainGpuDestroys(-1);
 
+        if (priority_index == unresolved_index)
+        {
+            // Opened ahead of the walk: only the provisional task exists until
+            // syncIndexer() has placed it.
+            if (!priority_task)
+            {
+                return false;
+            }
+
+            m_indexer.holdProbe(priority_task->prepare_state.load() == PrepareState::Preparing);
+            prioritize(priority_task);
+            logDecodeTiming(*priority_task);
+            return updateDecodeTask(*priority_task);
+        }
+
         // Refresh the pin window first so the visible image and its prefetch window
         // are in the eviction-immune overlay before cancelStaleDecodes()/tickPrefetch()
         // run (a prefetch insert here could otherwise evict the just-navigated image).
@@ -1728,9 +2541,12 @@ namespace ifap
         // finished prepare; abortNonPriorityWork() (from getTexture priority) already
         // cleared competing I/O on navigation.
         repin(priority_index);
+        prioritize(priority_task ? priority_task : lookupTask(priority_index));
 
         cancelStaleDecodes(priority_index);
         tickPrefetch(priority_index);
+        trimTileSources(priority_index);
+        scheduleReadahead(priority_index);
 
         // Adapt the GPU upload budget: stay conservative for a few frames after the
         // visible image changes (so navigation stays snappy), then ramp up so a
@@ -1738,6 +2554,7 @@ namespace ifap
         if (priority_index != m_last_priority_index)
         {
             m_last_priority_index = priority_index;
+            m_indexer.expandNear(priority_index, texture_prefetch_size * 2);
             m_upload_settle_frames = texture_upload_settle_frames;
         }
 
@@ -1763,6 +2580,9 @@ namespace ifap
         // Prefer the AppView's current task so a cold drop cannot miss cache lookup.
         std::shared_ptr<DecodeTask> priority_entry = priority_task ? priority_task : lookupTask(priority_index);
 
+        // Keep the header probe off the disk while the visible image is being read.
+        m_indexer.holdProbe(priority_entry && priority_entry->prepare_state.load() == PrepareState::Preparing);
+
         if (trace_decode)
         {
             // Report transitions only (this runs at the frame poll rate). The key signal
@@ -1840,7 +2660,9 @@ namespace ifap
                 return;
             }
 
-            if (!task_ptr->hasPendingUpdates() && task_ptr->gpu_texture_ready)
+            // A reduced preview has no pending rects; its reducer tracks the progress
+            // (and releasing it needs a final pass once the decode is done).
+            if (!task_ptr->hasPendingUpdates() && task_ptr->gpu_texture_ready && !task_ptr->reducer)
             {
                 return;
             }
@@ -1855,4 +2677,19 @@ namespace ifap
         return progress;
     }
 
+    bool TextureCache::updateTiles(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request, int32x2 viewport)
+    {
+        if (m_shutdown)
+        {
+            return false;
+        }
+
+        return m_virtual.update(task, request, viewport);
+    }
+
+    void TextureCache::drawTiles(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request)
+    {
+        m_virtual.draw(task, request);
+    }
+
 } // namespace ifap
@@ -4,8 +4,18 @@
 */
 #pragma once
 
+#include "async_reader.hpp"
+#include "block_pool.hpp"
+#include "box_reducer.hpp"
+#include "container_pool.hpp"
+#include "container_slice.hpp"
 #include "context.hpp"
+#include "decode_scheduler.hpp"
+#include "file_cache.hpp"
 #include "indexer.hpp"
+#include "readahead.hpp"
+#include "solid_extractor.hpp"
+#include "virtual_texture.hpp"
 #include "render/vk/vk_renderer.hpp"
 
 #include <mango/core/buffer.hpp>
@@ -46,13 +56,18 @@ namespace ifap
         // The whole compressed file, read once into RAM on the worker thread (bulk
         // sequential I/O, off the UI thread). The decoder reads from this, so it must
         // outlive the async decode; it is released once the decode has finished.
-        // Mid-read aborts stash a prefix in TextureCache::m_partial_reads so a later
-        // prepare for the same index can resume instead of re-reading from offset 0.
-        std::unique_ptr<Buffer> buffer;
-        size_t read_bytes = 0; // valid prefix length while a chunked read is in progress
+        // Released into TextureCache::m_file_cache rather than freed, so a re-decode
+        // skips the read; a mid-read abort stashes the prefix there to resume from.
+        std::unique_ptr<PooledBuffer> buffer;
+        s64 file_stamp = 0; // modification stamp the buffer was read at
+        std::shared_ptr<File> mapping; // instead of `buffer`: large local file or stored member's container (see mapFile)
+        size_t read_bytes = 0; // valid prefix of `buffer` (an aborted read leaves a prefix)
         std::unique_ptr<ImageDecoder> decoder;
-        std::unique_ptr<Bitmap> bitmap;
-        std::unique_ptr<Bitmap> scaled_bitmap;
+        std::unique_ptr<PooledBitmap> bitmap;
+        std::unique_ptr<PooledBitmap> scaled_bitmap;
+        std::unique_ptr<StreamingBoxReducer> reducer; // fills scaled_bitmap from a sparse `bitmap`
+        int preview_rows = 0;                         // scaled_bitmap rows uploaded (main thread)
+        bool tiled = false;                           // `bitmap` is kept for VirtualTexture once the preview is done
         ImageDecodeFuture future;
 
         GpuTexture texture;
@@ -86,12 +101,13 @@ namespace ifap
         // Input -> scene-linear BT.709 color pipeline. When needs_color_convert is set the
         // worker decodes into `bitmap` (native encoded layout) and linearize()s each rect
         // into `convert_bitmap` (always fp16 scene-linear BT.709), which is what gets
-        // uploaded. Fast-path images (BT.709 sRGB/linear, handled by the VkFormat) leave
+        // uploaded (a downscaled preview is linearized by its reducer instead and has no
+        // convert_bitmap). Fast-path images (BT.709 sRGB/linear, handled by the VkFormat) leave
         // this clear and upload straight from `bitmap`. ICC-tagged images also skip
         // linearize() and stay on the hardware sRGB path until ColorManager lands.
         bool needs_color_convert = false;
         ColorInfo header_color;
-        std::unique_ptr<Bitmap> convert_bitmap;
+        std::unique_ptr<PooledBitmap> convert_bitmap;
 
         std::atomic<PrepareState> prepare_state { PrepareState::Pending };
 
@@ -100,9 +116,18 @@ namespace ifap
         float progress = 0.0f;
         u64 last_preview_ms = 0;
 
+        // Header probe result at request time (ImageFileIndexer::metadata); invalid when
+        // the probe had not reached the file yet.
+        ImageMetadata metadata;
+
+        // Share of the decode pipeline, held from request until the decode finishes.
+        DecodeScheduler::Ticket ticket;
+
         // Timing instrumentation.
         std::string name;
-        size_t index = 0;                        // position in the indexer (for tracing)
+        size_t index = 0;                        // position in the indexer (main thread; see WorkerJob::index)
+        std::atomic<u64> prepare_start_ms { 0 }; // worker picked the task up
+        std::atomic<u64> read_end_ms { 0 };      // whole file read (or resident)
         std::atomic<u64> decode_start_ms { 0 };  // set on worker just before launch()
         std::atomic<u64> decode_first_ms { 0 };  // first decode callback (first pixels)
         bool decode_logged = false;              // main thread only
@@ -126,6 +151,16 @@ namespace ifap
         std::function<void()> m_on_content_changed;
         std::function<bool()> m_should_abort;
 
+        // Decode admission and priority; replaces walking the caches for the count.
+        DecodeScheduler m_scheduler { texture_inflight_decode_limit, texture_inflight_decode_bytes, [this]
+        {
+            if (m_on_content_changed)
+            {
+                m_on_content_changed();
+            }
+        }};
+        std::weak_ptr<DecodeTask> m_visible_task;
+
         std::atomic<bool> m_shutdown { false };
 
         // Navigation tracking for the adaptive upload budget.
@@ -151,6 +186,11 @@ namespace ifap
         std::vector<size_t> m_pin_set;
 
         ImageFileIndexer m_indexer;
+        size_t m_indexer_generation = 0;
+
+        // A file opened directly is prepared before the walk has published it. Its task
+        // waits here, outside both stores, until syncIndexer() finds its position.
+        std::shared_ptr<DecodeTask> m_provisional;
 
         std::shared_ptr<Path> m_current_path;
 
@@ -164,17 +204,29 @@ namespace ifap
 
             Type type = Type::Prepare;
             std::shared_ptr<DecodeTask> task;
+            size_t index = 0; // task->index when queued; the prepare lane reads only this copy
             TextureHandle gpu_handle = 0;
         };
 
-        // Prepare lane: allocates bitmaps and launches the async decode. These jobs
-        // are quick and must never wait, so they live on their own thread.
-        std::thread m_worker;
+        // Prepare lanes: read the file, allocate bitmaps and launch the async decode.
+        // Navigation must never wait behind disposal, so these live on their own
+        // threads. Only the first m_prepare_lanes threads take jobs (see
+        // setPrepareLanes); the rest idle.
+        std::vector<std::thread> m_workers;
         std::mutex m_worker_mutex;
         std::condition_variable m_worker_cv;
         bool m_worker_running = true;
+        size_t m_prepare_lanes = 1;
         std::deque<WorkerJob> m_worker_jobs;
 
+        // One per prepare thread; null while texture_async_reads is off.
+        std::vector<std::unique_ptr<AsyncFileReader>> m_readers;
+
+        // Page-cache warming beyond the prefetch window (see scheduleReadahead).
+        ReadaheadLane m_readahead;
+        size_t m_readahead_index = size_t(-1);
+        int m_readahead_direction = 0;
+
         // Disposal lane: joins the decode future (which can block until the decode
         // finishes/cancels) and frees CPU buffers. Kept on a separate "reaper" thread
         // so a blocking join can never stall navigation or prefetch.
@@ -194,31 +246,45 @@ namespace ifap
         // owned by the cache and freed in the destructor.
         TextureHandle m_placeholder = 0;
 
+        // Full-resolution tiles of the visible oversize image.
+        VirtualTexture m_virtual { m_renderer, [this] (TextureHandle handle)
+        {
+            std::lock_guard lock(m_gpu_destroy_mutex);
+            m_gpu_destroy_queue.push_back(handle);
+        }};
+
         int m_prefetch_direction = 0;
 
-        // Partial file reads preserved across abort/resume. Keyed by indexer index;
-        // the worker stashes a prefix when a chunked read is abandoned, and the next
-        // prepare for that index picks it up. Bounded so fast scrolling cannot retain
-        // an unbounded number of huge half-read buffers.
-        struct PartialFileRead
-        {
-            std::unique_ptr<Buffer> buffer;
-            size_t bytes = 0;
-        };
+        // Compressed bytes of released textures and of reads abandoned half way, so a
+        // later prepare for the same file skips or resumes the read. Byte-budgeted LRU.
+        FileCache m_file_cache { texture_file_cache_bytes };
+
+        // Feeds m_file_cache from solid archives (see scheduleSolidExtraction).
+        SolidArchiveExtractor m_extractor { m_file_cache };
+        std::unordered_map<std::string, ContainerKind> m_container_kinds;
+
+        // Shared mappings of containers with stored (uncompressed) members.
+        ContainerSlices m_slices { texture_slice_containers };
+
+        // Inflates ZIP members of the visible image and the prefetch window in parallel
+        // (see scheduleContainerExtraction).
+        ContainerExtractPool m_container_pool { m_file_cache, m_slices, texture_zip_extract_threads };
 
-        std::mutex m_partial_mutex;
-        std::unordered_map<size_t, PartialFileRead> m_partial_reads;
+        ContainerSlices::Slice mapFile(const std::string& pathname);
 
-        void stashPartialRead(size_t index, std::unique_ptr<Buffer> buffer, size_t bytes);
-        PartialFileRead takePartialRead(size_t index);
-        void clearPartialReads();
+        void retainFileBytes(DecodeTask& task);
 
         std::shared_ptr<DecodeTask> makeTask();
+        std::shared_ptr<DecodeTask> launchTask(std::string name, size_t index, bool priority);
         void deferDispose(DecodeTask* task);
         void enqueuePrepare(WorkerJob job, bool front = false);
         void enqueueDispose(WorkerJob job);
         void abortNonPriorityWork(size_t priority_index);
         void cancelStaleDecodes(size_t priority_index);
+        void scheduleReadahead(size_t priority_index);
+        void scheduleSolidExtraction(size_t priority_index);
+        void scheduleContainerExtraction(size_t priority_index);
+        ContainerKind cachedContainerKind(const std::string& container);
 
         // Pinned-overlay helpers (see m_pinned).
         bool isPinIndex(size_t index) const;
@@ -227,17 +293,31 @@ namespace ifap
         void repin(size_t priority_index);
         void forEachTask(const std::function<void(size_t, std::shared_ptr<DecodeTask>&)>& fn);
 
-        void workerThreadMain();
+        // Indexer change tracking (see syncIndexer).
+        void rekeyTasks(const std::function<size_t(DecodeTask&)>& remap);
+        void refreshQueuedPrepares();
+        void remapByName(size_t& index);
+        void remapByEdits(const std::vector<IndexEdit>& edits, size_t& index);
+        bool resolveProvisional(size_t& index);
+
+        void workerThreadMain(size_t lane);
+        void setPrepareLanes(const std::string& pathname);
         void reaperThreadMain();
-        void runPrepare(const std::shared_ptr<DecodeTask>& task);
+        void runPrepare(const std::shared_ptr<DecodeTask>& task, size_t index, AsyncFileReader* reader);
         void runDispose(WorkerJob job);
         void drainGpuDestroys(int budget);
         bool finishGpuSetup(DecodeTask& task);
         void logDecodeTiming(DecodeTask& task);
-        size_t countActiveDecodes() const;
+        void prioritize(const std::shared_ptr<DecodeTask>& task);
         void tickPrefetch(size_t priority_index);
+        void trimTileSources(size_t priority_index);
 
     public:
+        // Returned by setCurrentPath() while the opened file is still being located by
+        // the indexer; getTexture() hands out its task and syncIndexer() later replaces
+        // the index with the real position.
+        static constexpr size_t unresolved_index = size_t(-2);
+
         explicit TextureCache(VKRenderer& renderer,
                               std::function<void()> on_content_changed = {},
                               std::function<bool()> should_abort = {});
@@ -248,11 +328,23 @@ namespace ifap
         operator const ImageFileIndexer& () const;
 
         size_t setCurrentPath(const std::string& name);
+
+        // Follows the indexer when its positions change (see ImageFileIndexer::generation):
+        // a replaced list re-keys cached tasks by name, watch-mode edits remap them in
+        // place, and `index` follows the same file. Returns true when positions changed;
+        // a task whose file vanished gets index -1.
+        bool syncIndexer(size_t& index);
         std::shared_ptr<DecodeTask> getTexture(size_t index, bool priority = false);
         void setPrefetchDirection(int direction);
         bool updateDecodeTask(DecodeTask& task);
         bool update(size_t priority_index, const std::shared_ptr<DecodeTask>& priority_task = {});
 
+        // Detail tiles of an oversize image for the view about to be drawn (see
+        // VirtualTexture): updateTiles() after update(), drawTiles() after the image's
+        // drawImage(). updateTiles() returns true while tiles are still streaming in.
+        bool updateTiles(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request, int32x2 viewport);
+        void drawTiles(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request);
+
     protected:
         void uploadDownscaledPreview(DecodeTask& task);
     };
@@ -0,0 +1,482 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#include "virtual_texture.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ifap
+{
+    using namespace mango;
+
+    namespace
+    {
+
+        constexpr int tile_content = texture_tile_slot_size - 2 * texture_tile_border;
+
+        int levelSize(int size, int level)
+        {
+            return (size + (1 << level) - 1) >> level;
+        }
+
+        u64 tileKey(int level, int x, int y)
+        {
+            return (u64(level) << 56) | (u64(u32(y)) << 28) | u64(u32(x));
+        }
+
+    } // namespace
+
+    VirtualTexture::VirtualTexture(VKRenderer& renderer, std::function<void(TextureHandle)> retire)
+        : m_renderer(renderer)
+        , m_retire(std::move(retire))
+    {
+    }
+
+    VirtualTexture::~VirtualTexture()
+    {
+        if (m_atlas)
+        {
+            m_renderer.destroyTexture(m_atlas);
+        }
+    }
+
+    bool VirtualTexture::isCurrent(const std::shared_ptr<DecodeTask>& task) const
+    {
+        return task && !m_task.owner_before(task) && !task.owner_before(m_task) &&
+            m_source == task->bitmap.get();
+    }
+
+    void VirtualTexture::reset()
+    {
+        m_page_table.clear();
+        m_free.clear();
+
+        // A slot drawn by a frame still in flight keeps its age and is only evicted
+        // once it has retired, like any other (see acquireSlot()).
+        for (size_t i = m_slots.size(); i-- > 0; )
+        {
+            Slot& slot = m_slots[i];
+
+            if (slot.used && m_frame - slot.last_used <= texture_tile_retire_frames)
+            {
+                continue;
+            }
+
+            slot = Slot();
+            m_free.push_back(u32(i));
+        }
+
+        m_atlas_failed = false;
+    }
+
+    bool VirtualTexture::ensureAtlas(PixelFormat format)
+    {
+        if (m_atlas && m_format == format)
+        {
+            return true;
+        }
+
+        if (m_atlas_failed)
+        {
+            return false;
+        }
+
+        if (m_atlas)
+        {
+            m_retire(m_atlas);
+            m_atlas = 0;
+        }
+
+        const int limit = std::min(texture_tile_atlas_size, m_renderer.getMaxTextureDimension());
+        const int slots_per_row = limit / texture_tile_slot_size;
+
+        if (slots_per_row < 1)
+        {
+            m_atlas_failed = true;
+            return false;
+        }
+
+        const int size = slots_per_row * texture_tile_slot_size;
+
+        m_atlas = m_renderer.createTexture(size, size, format, nullptr);
+        if (!m_atlas)
+        {
+            m_atlas_failed = true;
+            return false;
+        }
+
+        m_format = format;
+        m_atlas_size = size;
+        m_slots_per_row = slots_per_row;
+        m_slots.assign(size_t(slots_per_row) * slots_per_row, Slot());
+        reset();
+
+        return true;
+    }
+
+    bool VirtualTexture::acquireSlot(u32& slot)
+    {
+        if (!m_free.empty())
+        {
+            slot = m_free.back();
+            m_free.pop_back();
+            return true;
+        }
+
+        // Least recently drawn tile that no frame still in flight can be sampling.
+        size_t victim = m_slots.size();
+
+        for (size_t i = 0; i < m_slots.size(); ++i)
+        {
+            const Slot& candidate = m_slots[i];
+
+            if (candidate.used && m_frame - candidate.last_used > texture_tile_retire_frames &&
+                (victim == m_slots.size() || candidate.last_used < m_slots[victim].last_used))
+            {
+                victim = i;
+            }
+        }
+
+        if (victim == m_slots.size())
+        {
+            return false;
+        }
+
+        // A slot aged across a reset() no longer has a page table entry; its key may
+        // name a tile of the new image.
+        auto it = m_page_table.find(m_slots[victim].key);
+        if (it != m_page_table.end() && it->second == victim)
+        {
+            m_page_table.erase(it);
+        }
+
+        m_slots[victim] = Slot();
+        slot = u32(victim);
+
+        return true;
+    }
+
+    void VirtualTexture::buildTile(const DecodeTask& task, int level, Tile tile, u8* dest) const
+    {
+        const PooledBitmap& source = *task.bitmap;
+        const int step = 1 << level;
+        const int width = levelSize(source.width, level);
+        const int height = levelSize(source.height, level);
+
+        // The slot holds the tile plus a border of its neighbours' texels (clamped at
+        // the image edge), so filtering across tile seams matches the full image.
+        const int origin_x = tile.x * tile_content - texture_tile_border;
+        const int origin_y = tile.y * tile_content - texture_tile_border;
+
+        for (int v = 0; v < texture_tile_slot_size; ++v)
+        {
+            const int y0 = std::clamp(origin_y + v, 0, height - 1) * step;
+            const int y1 = std::min(y0 + step, source.height);
+
+            u8* d = dest + size_t(v) * texture_tile_slot_size * 4;
+
+            for (int u = 0; u < texture_tile_slot_size; ++u)
+            {
+                const int x0 = std::clamp(origin_x + u, 0, width - 1) * step;
+
+                if (!level)
+                {
+                    std::memcpy(d, source.image + size_t(y0) * source.stride + size_t(x0) * 4, 4);
+                    d += 4;
+                    continue;
+                }
+
+                const int x1 = std::min(x0 + step, source.width);
+
+                u32 sum[4] = { 0, 0, 0, 0 };
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    const u8* s = source.image + size_t(y) * source.stride + size_t(x0) * 4;
+
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        sum[0] += s[0];
+                        sum[1] += s[1];
+                        sum[2] += s[2];
+                        sum[3] += s[3];
+                        s += 4;
+                    }
+                }
+
+                const u32 count = u32(y1 - y0) * u32(x1 - x0);
+                for (int c = 0; c < 4; ++c)
+                {
+                    d[c] = u8((sum[c] + count / 2) / count);
+                }
+
+                d += 4;
+            }
+        }
+    }
+
+    bool VirtualTexture::update(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request, int32x2 viewport)
+    {
+        ++m_frame;
+        m_level = -1;
+        m_visible.clear();
+
+        // Tiles come from the finished decode; until then the preview is all there is.
+        if (!texture_virtual_tiles || !task || !task->tiled || !task->bitmap || task->reducer ||
+            !task->gpu_texture_ready)
+        {
+            return false;
+        }
+
+        if (!isCurrent(task))
+        {
+            reset();
+            m_task = task;
+            m_source = task->bitmap.get();
+        }
+
+        const PooledBitmap& source = *task->bitmap;
+
+        // Screen pixels covered by the whole image, and full-resolution texels per pixel.
+        const float screen_width = request.scale.x * float(std::max(1, viewport.x));
+        const float screen_height = request.scale.y * float(std::max(1, viewport.y));
+
+        if (screen_width <= 0.0f || screen_height <= 0.0f)
+        {
+            return false;
+        }
+
+        float density = std::min(float(source.width) / screen_width, float(source.height) / screen_height);
+
+        // The preview already has a texel for every pixel.
+        if (density * float(task->downscale_width) / float(source.width) >= 1.0f)
+        {
+            return false;
+        }
+
+        int level = 0;
+        while (density >= 2.0f)
+        {
+            density *= 0.5f;
+            ++level;
+        }
+
+        // Visible part of the image quad ([-1, 1] on both axes, see ImageDrawRequest).
+        const float view_x0 = std::max(-1.0f, -1.0f / request.scale.x - request.translate.x);
+        const float view_x1 = std::min(1.0f, 1.0f / request.scale.x - request.translate.x);
+        const float view_y0 = std::max(-1.0f, -1.0f / request.scale.y - request.translate.y);
+        const float view_y1 = std::min(1.0f, 1.0f / request.scale.y - request.translate.y);
+
+        if (view_x0 >= view_x1 || view_y0 >= view_y1 || !ensureAtlas(task->texture.format))
+        {
+            return false;
+        }
+
+        int tile_x0 = 0;
+        int tile_x1 = 0;
+        int tile_y0 = 0;
+        int tile_y1 = 0;
+
+        // A view that needs more tiles than the atlas holds steps to a coarser level.
+        for ( ; ; ++level)
+        {
+            const int width = levelSize(source.width, level);
+            const int height = levelSize(source.height, level);
+
+            if (width <= task->downscale_width || height <= task->downscale_height)
+            {
+                return false;
+            }
+
+            const float tiles_x = float(width) / float(tile_content);
+            const float tiles_y = float(height) / float(tile_content);
+
+            tile_x0 = std::max(0, int(std::floor((view_x0 + 1.0f) * 0.5f * tiles_x)));
+            tile_x1 = std::min(int(std::ceil(tiles_x)), int(std::ceil((view_x1 + 1.0f) * 0.5f * tiles_x)));
+            tile_y0 = std::max(0, int(std::floor((view_y0 + 1.0f) * 0.5f * tiles_y)));
+            tile_y1 = std::min(int(std::ceil(tiles_y)), int(std::ceil((view_y1 + 1.0f) * 0.5f * tiles_y)));
+
+            if (size_t(tile_x1 - tile_x0) * size_t(tile_y1 - tile_y0) <= m_slots.size())
+            {
+                break;
+            }
+        }
+
+        for (int y = tile_y0; y < tile_y1; ++y)
+        {
+            for (int x = tile_x0; x < tile_x1; ++x)
+            {
+                m_visible.push_back({ x, y });
+            }
+        }
+
+        // Centre of the view first.
+        const float center_x = (tile_x0 + tile_x1 - 1) * 0.5f;
+        const float center_y = (tile_y0 + tile_y1 - 1) * 0.5f;
+
+        std::sort(m_visible.begin(), m_visible.end(), [center_x, center_y] (const Tile& a, const Tile& b)
+        {
+            const float da = (a.x - center_x) * (a.x - center_x) + (a.y - center_y) * (a.y - center_y);
+            const float db = (b.x - center_x) * (b.x - center_x) + (b.y - center_y) * (b.y - center_y);
+            return da < db;
+        });
+
+        m_level = level;
+
+        // Resident tiles of this view are not eviction candidates while missing ones
+        // are brought in.
+        for (const Tile& tile : m_visible)
+        {
+            auto it = m_page_table.find(tileKey(level, tile.x, tile.y));
+            if (it != m_page_table.end())
+            {
+                m_slots[it->second].last_used = m_frame;
+            }
+        }
+
+        // A tile at level n reads 4^n source texels per texel; keep the per-frame work
+        // roughly constant.
+        const size_t budget = std::max(size_t(1), texture_tile_uploads_per_frame >> std::min(2 * level, 16));
+
+        const size_t slot_bytes = size_t(texture_tile_slot_size) * texture_tile_slot_size * 4;
+        m_staging.resize(slot_bytes * budget);
+
+        std::vector<TextureRegionUpload> regions;
+        std::vector<u32> pending;
+        bool missing = false;
+
+        for (const Tile& tile : m_visible)
+        {
+            const u64 key = tileKey(level, tile.x, tile.y);
+
+            if (m_page_table.count(key))
+            {
+                continue;
+            }
+
+            missing = true;
+
+            u32 slot = 0;
+            if (pending.size() >= budget || !acquireSlot(slot))
+            {
+                break;
+            }
+
+            u8* pixels = m_staging.data() + pending.size() * slot_bytes;
+            buildTile(*task, level, tile, pixels);
+
+            TextureRegionUpload region =
+            {
+                .x = int(slot % m_slots_per_row) * texture_tile_slot_size,
+                .y = int(slot / m_slots_per_row) * texture_tile_slot_size,
+                .width = texture_tile_slot_size,
+                .height = texture_tile_slot_size,
+                .pixels = pixels,
+            };
+
+            regions.push_back(region);
+            pending.push_back(slot);
+            m_slots[slot].key = key;
+        }
+
+        if (pending.empty())
+        {
+            return missing;
+        }
+
+        // The renderer copies into staging before returning; tiles past the per-frame
+        // upload budget (or all, with the upload slots busy) go back and retry.
+        const size_t submitted = m_renderer.uploadTextureRegions(m_atlas, m_format, regions.data(), regions.size());
+
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            Slot& slot = m_slots[pending[i]];
+
+            if (i < submitted)
+            {
+                slot.used = true;
+                slot.last_used = m_frame;
+                m_page_table[slot.key] = pending[i];
+            }
+            else
+            {
+                slot = Slot();
+                m_free.push_back(pending[i]);
+            }
+        }
+
+        return true;
+    }
+
+    void VirtualTexture::draw(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request)
+    {
+        if (m_level < 0 || !m_atlas || !isCurrent(task))
+        {
+            return;
+        }
+
+        const PooledBitmap& source = *task->bitmap;
+        const int step = 1 << m_level;
+        const int width = levelSize(source.width, m_level);
+        const int height = levelSize(source.height, m_level);
+        const float atlas = float(m_atlas_size);
+
+        std::vector<ImageRegionDraw> regions;
+        regions.reserve(m_visible.size());
+
+        for (const Tile& tile : m_visible)
+        {
+            auto it = m_page_table.find(tileKey(m_level, tile.x, tile.y));
+            if (it == m_page_table.end())
+            {
+                continue;
+            }
+
+            const u32 slot = it->second;
+            m_slots[slot].last_used = m_frame;
+
+            // Tile rect in level texels, then in the image quad's [-1, 1] space.
+            const int x0 = tile.x * tile_content;
+            const int y0 = tile.y * tile_content;
+            const int x1 = std::min(x0 + tile_content, width);
+            const int y1 = std::min(y0 + tile_content, height);
+
+            const float ax = -1.0f + 2.0f * float(x0 * step) / float(source.width);
+            const float bx = -1.0f + 2.0f * float(std::min(x1 * step, source.width)) / float(source.width);
+            const float ay = -1.0f + 2.0f * float(y0 * step) / float(source.height);
+            const float by = -1.0f + 2.0f * float(std::min(y1 * step, source.height)) / float(source.height);
+
+            // The quad spans [-1, 1]; place it over [a, b] under the image's transform.
+            const float32x2 half((bx - ax) * 0.5f, (by - ay) * 0.5f);
+            const float32x2 center((ax + bx) * 0.5f, (ay + by) * 0.5f);
+
+            ImageRegionDraw region;
+            region.translate = float32x2((center.x + request.translate.x) / half.x,
+                                         (center.y + request.translate.y) / half.y);
+            region.scale = float32x2(request.scale.x * half.x, request.scale.y * half.y);
+            region.texture_offset = float32x2(
+                float(int(slot % m_slots_per_row) * texture_tile_slot_size + texture_tile_border) / atlas,
+                float(int(slot / m_slots_per_row) * texture_tile_slot_size + texture_tile_border) / atlas);
+            region.texture_scale = float32x2(float(x1 - x0) / atlas, float(y1 - y0) / atlas);
+
+            regions.push_back(region);
+        }
+
+        if (regions.empty())
+        {
+            return;
+        }
+
+        ImageDrawRequest atlas_request = request;
+        atlas_request.texture = m_atlas;
+        atlas_request.width = m_atlas_size;
+        atlas_request.height = m_atlas_size;
+
+        m_renderer.drawImageRegions(atlas_request, regions.data(), regions.size());
+    }
+
+} // namespace ifap
@@ -0,0 +1,97 @@
+/*
+    iFap Image Viewer Example for MANGO
+    Copyright 2013-2026 Twilight 3D Finland Oy. All rights reserved.
+*/
+#pragma once
+
+#include <mango/mango.hpp>
+#include <mango/math/vector.hpp>
+
+#include "context.hpp"
+#include "render/vk/vk_renderer.hpp"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ifap
+{
+    using mango::u8;
+    using mango::u32;
+    using mango::u64;
+    using mango::math::int32x2;
+
+    struct DecodeTask;
+
+    // Full-resolution detail for images above the GPU texture limit, which otherwise
+    // only have their downscaled preview. Tiles of the visible image's retained decode
+    // (see DecodeTask::tiled) live in slots of one atlas texture; a page table maps
+    // (mip level, tile) to its slot. Each frame the view picks the level whose texels
+    // are at least as dense as the screen's pixels, the missing tiles under it are
+    // cut from the decode (box-reduced for coarser levels) and uploaded a few per
+    // frame, nearest the centre first, evicting the least recently drawn tiles. The
+    // preview is drawn first and the resident tiles over it, so a tile still missing
+    // shows the preview. Only the visible image has tiles. Main thread only.
+    class VirtualTexture
+    {
+    protected:
+        struct Slot
+        {
+            u64 key = 0;
+            u64 last_used = 0; // frame the tile was last drawn
+            bool used = false;
+        };
+
+        struct Tile
+        {
+            int x;
+            int y;
+        };
+
+        VKRenderer& m_renderer;
+        std::function<void(TextureHandle)> m_retire; // deferred destroy of a replaced atlas
+
+        TextureHandle m_atlas = 0;
+        PixelFormat m_format = PixelFormat::RGBA8_UNORM;
+        int m_atlas_size = 0;
+        int m_slots_per_row = 0;
+        bool m_atlas_failed = false; // no VRAM for it; not retried for this image
+
+        std::vector<Slot> m_slots;
+        std::vector<u32> m_free;
+        std::unordered_map<u64, u32> m_page_table; // tile key -> slot
+
+        std::weak_ptr<DecodeTask> m_task; // image the atlas holds tiles of
+        const void* m_source = nullptr;   // its full-resolution bitmap
+
+        // View chosen by update() and drawn by draw().
+        int m_level = -1; // -1: the preview is sharp enough on its own
+        std::vector<Tile> m_visible;
+        u64 m_frame = 0;
+
+        std::vector<u8> m_staging;
+
+        bool isCurrent(const std::shared_ptr<DecodeTask>& task) const;
+        void reset();
+        bool ensureAtlas(PixelFormat format);
+        bool acquireSlot(u32& slot);
+        void buildTile(const DecodeTask& task, int level, Tile tile, u8* dest) const;
+
+    public:
+        // retire receives an atlas that may still be sampled by a frame in flight.
+        VirtualTexture(VKRenderer& renderer, std::function<void(TextureHandle)> retire);
+        ~VirtualTexture();
+
+        VirtualTexture(const VirtualTexture&) = delete;
+        VirtualTexture& operator = (const VirtualTexture&) = delete;
+
+        // Picks the level for the view about to be drawn and uploads missing tiles.
+        // Returns true while visible tiles are still missing.
+        bool update(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request, int32x2 viewport);
+
+        // Draws the resident visible tiles; call right after the preview's drawImage().
+        void draw(const std::shared_ptr<DecodeTask>& task, const ImageDrawRequest& request);
+    };
+
+} // namespace ifap